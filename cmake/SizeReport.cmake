@@ -0,0 +1,51 @@
+# Appends the size of a built binary to a report file, with its difference
+# from a baseline build.
+# Usage: cmake -DBINARY=<file> -DLABEL=<name> -DREPORT=<file> [-DBASELINE=<file>] -P SizeReport.cmake
+# Without BASELINE the first entry already in the report is the baseline.
+cmake_minimum_required(VERSION 3.14)
+
+if(NOT EXISTS "${BINARY}")
+    message(FATAL_ERROR "SizeReport: binary not found: ${BINARY}")
+endif()
+
+file(SIZE "${BINARY}" BINARY_SIZE)
+math(EXPR BINARY_KB "${BINARY_SIZE} / 1024")
+string(TIMESTAMP NOW "%Y-%m-%d %H:%M:%S")
+
+set(BASELINE_SIZE "")
+if(BASELINE)
+    if(NOT EXISTS "${BASELINE}")
+        message(FATAL_ERROR "SizeReport: baseline binary not found: ${BASELINE}")
+    endif()
+    file(SIZE "${BASELINE}" BASELINE_SIZE)
+    set(BASELINE_NAME "${BASELINE}")
+elseif(EXISTS "${REPORT}")
+    file(STRINGS "${REPORT}" FIRST_ENTRY LIMIT_COUNT 1)
+    if(FIRST_ENTRY MATCHES "^[^ ]+ [^ ]+  ([^ ]+)  ([0-9]+) bytes")
+        set(BASELINE_NAME "${CMAKE_MATCH_1}")
+        set(BASELINE_SIZE "${CMAKE_MATCH_2}")
+    endif()
+endif()
+
+set(LINE "${NOW}  ${LABEL}  ${BINARY_SIZE} bytes (${BINARY_KB} KiB)")
+if(NOT BASELINE_SIZE STREQUAL "")
+    math(EXPR DELTA "${BINARY_SIZE} - ${BASELINE_SIZE}")
+    # Tenths of a percent, rounded toward zero
+    math(EXPR PERMILLE "${DELTA} * 1000 / ${BASELINE_SIZE}")
+    math(EXPR PERCENT_WHOLE "${PERMILLE} / 10")
+    math(EXPR PERCENT_TENTH "${PERMILLE} % 10")
+    if(PERCENT_TENTH LESS 0)
+        math(EXPR PERCENT_TENTH "-${PERCENT_TENTH}")
+    endif()
+    set(SIGN "")
+    if(DELTA GREATER_EQUAL 0)
+        set(SIGN "+")
+    elseif(PERCENT_WHOLE EQUAL 0)
+        # -0.x: the whole part lost its sign
+        set(PERCENT_WHOLE "-0")
+    endif()
+    string(APPEND LINE "  ${SIGN}${DELTA} bytes (${SIGN}${PERCENT_WHOLE}.${PERCENT_TENTH}%) vs ${BASELINE_NAME}")
+endif()
+
+message(STATUS "FLRP size: ${LINE}")
+file(APPEND "${REPORT}" "${LINE}\n")
@@ -94,7 +94,7 @@ class MidiControllerConfig:
             "plugin": self._ActivePlugin,
             "timestamp": self.session_start_time,
             "project_name": general.getProjectTitle(),  # Track current project
-            "write_time": int(time.time())  # Track when file was written
+            "write_time": round(time.time(), 3)  # When the file was written (Unix seconds, ms precision) for staleness metrics
         }
         
         max_retries = 3
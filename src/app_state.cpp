@@ -1,38 +1,63 @@
 #include "app_state.h"
 #include "discord_rp.h"
-#include "monitor.h"
 #include "parser.h"
-#include <iostream>
+#include "logger.h"
+#include "trace.h"
 #include <chrono>
+#include <thread>
 #include <algorithm>
 
-AppState::AppState() 
+// Passed by reference to std::chrono, so it needs a definition
+const int AppState::WAKEUPS_REFRESH_MS;
+
+// A log record holds a few hundred bytes, so multi-line reports go out a line at a time
+static void logReport(std::string_view report) {
+    while (!report.empty()) {
+        size_t end = report.find('\n');
+        LOG_DEBUG("{}", report.substr(0, end));
+        if (end == std::string_view::npos) {
+            break;
+        }
+        report.remove_prefix(end + 1);
+    }
+}
+
+AppState::AppState(Clock& clock)
     : m_currentState(State::STOPPED)
     , m_shouldExit(false)
     , m_debugMode(false)
-    , m_pollInterval(1000)
-    , m_discordId("1396127471342194719")
-    , m_sessionStartTime(0) {
+    , m_pendingCommand(Command::NONE)
+    , m_lastUpdateTime(0)
+    , m_droppedBefore(0)
+    , m_timedOutBefore(0)
+    , m_clock(clock)
+    , m_connector(clock)
+    , m_sensor(clock)
+    , m_sessionStartTime(0)
+    , m_paused(false)
+    , m_wakeups(clock.now())
+    , m_lastScanSequence(0) {
 }
 
 AppState::~AppState() {
     stopMonitoring();
 }
 
-bool AppState::initialize(const std::string& stateFile, int pollInterval, bool debugMode) {
-    m_stateFilePath = stateFile;
-    m_pollInterval = pollInterval;
-    m_debugMode.store(debugMode);
+bool AppState::initialize(const AppSettings& settings) {
+    m_settings = settings;
+    m_debugMode.store(settings.debugMode);
+    m_coalescer.setPolicy(settings.coalescePolicy);
     
-    // Initialize monitor
-    m_monitor = std::make_unique<ProcessMonitor>();
-    m_monitor->setDebugMode(debugMode);
+    // Process scans and state file reads run on the sensor thread
+    m_sensor.configure(settings.stateFilePath, settings.pollPolicy, settings.processMatcher);
+    m_sensor.setListener(&m_wakeup);
     
-    if (debugMode) {
-        std::cout << "📋 AppState initialized:" << std::endl;
-        std::cout << "  State file: " << m_stateFilePath << std::endl;
-        std::cout << "  Poll interval: " << m_pollInterval << "ms" << std::endl;
-        std::cout << "  Debug mode: " << (debugMode ? "enabled" : "disabled") << std::endl;
+    LOG_DEBUG("📋 AppState initialized: state file {}, poll interval {}ms ({}ms active, up to {}ms absent), debug mode {}, memory stats {}",
+              m_settings.stateFilePath, m_settings.pollPolicy.idleMs, m_settings.pollPolicy.activeMs,
+              m_settings.pollPolicy.absentMaxMs,
+              settings.debugMode ? "enabled" : "disabled", settings.memoryStats ? "enabled" : "disabled");
+    if (settings.memoryStats && !MemoryStats::hookInstalled()) {
+        LOG_WARN("⚠️ MEMORY_STATS needs a build with -DFLRP_MEMORY_STATS=ON; heap counters will read 0");
     }
     
     return true;
@@ -43,28 +68,15 @@ bool AppState::startMonitoring() {
         return true; // Already monitoring
     }
     
-    // Check if FL Studio state file is available
-    if (!FLParser::isFileAvailable(m_stateFilePath)) {
-        if (m_debugMode.load()) {
-            std::cout << "❌ FL Studio state file not found: " << m_stateFilePath << std::endl;
-        }
-        return false;
-    }
-    
-    // Initialize Discord connection
-    if (!initializeDiscord()) {
-        if (m_debugMode.load()) {
-            std::cout << "❌ Failed to initialize Discord RPC" << std::endl;
-        }
-        return false;
+    // Don't fail on a missing state file - it appears once the script runs in FL Studio
+    if (!FLParser::isFileAvailable(m_settings.stateFilePath)) {
+        LOG_DEBUG("❌ FL Studio state file not found: {}. Waiting for FL Studio to start...", m_settings.stateFilePath);
     }
     
     setState(State::MONITORING);
-    m_sessionStartTime = DiscordRPC::getCurrentTimestamp();
+    m_sensor.start();
     
-    if (m_debugMode.load()) {
-        std::cout << "✅ Started monitoring FL Studio" << std::endl;
-    }
+    LOG_DEBUG("✅ Started monitoring FL Studio");
     
     return true;
 }
@@ -74,100 +86,282 @@ bool AppState::stopMonitoring() {
         return true; // Already stopped
     }
     
+    m_sensor.stop();
+    setAudioSafe(false, 0);
     cleanupDiscord();
     setState(State::DISCONNECTED);
     
-    if (m_debugMode.load()) {
-        std::cout << "🔌 Stopped monitoring and disconnected from Discord" << std::endl;
-    }
+    LOG_DEBUG("🔌 Stopped monitoring and disconnected from Discord");
     
     return true;
 }
 
 bool AppState::refreshConnection() {
-    bool wasMonitoring = (m_currentState.load() == State::MONITORING);
-    
-    // Clean up existing connection
+    // Clean up existing connection; the next update() reconnects if FL Studio is running
     cleanupDiscord();
+    m_connector.resetBackoff();
+    setState(State::MONITORING);
+    m_sensor.start();
     
-    if (wasMonitoring) {
-        // Reinitialize if we were monitoring before
-        if (initializeDiscord()) {
-            setState(State::MONITORING);
-            if (m_debugMode.load()) {
-                std::cout << "🔄 Discord connection refreshed" << std::endl;
-            }
-            return true;
-        } else {
-            setState(State::DISCONNECTED);
-            if (m_debugMode.load()) {
-                std::cout << "❌ Failed to refresh Discord connection" << std::endl;
-            }
-            return false;
-        }
-    }
+    LOG_DEBUG("🔄 Refreshing Discord connection...");
     
-    setState(State::DISCONNECTED);
     return true;
 }
 
+void AppState::requestRefresh() {
+    m_pendingCommand.store(Command::REFRESH);
+    m_wakeup.signal();
+}
+
+void AppState::requestDisconnect() {
+    m_pendingCommand.store(Command::DISCONNECT);
+    m_wakeup.signal();
+}
+
+void AppState::requestPause() {
+    m_pendingCommand.store(Command::PAUSE);
+    m_wakeup.signal();
+}
+
+void AppState::requestResume() {
+    m_pendingCommand.store(Command::RESUME);
+    m_wakeup.signal();
+}
+
+void AppState::applyPendingCommand() {
+    // Latest request wins, like repeated clicks in the tray
+    Command command = m_pendingCommand.exchange(Command::NONE);
+    if (command == Command::REFRESH) {
+        refreshConnection();
+    } else if (command == Command::DISCONNECT) {
+        stopMonitoring();
+    } else if (command == Command::PAUSE) {
+        setPaused(true);
+    } else if (command == Command::RESUME) {
+        setPaused(false);
+    }
+}
+
+void AppState::setAudioSafe(bool recording, uint32_t flStudioPid) {
+    if (recording == m_audioSafe.active()) {
+        return;
+    }
+    
+    if (recording) {
+        m_audioSafe.enter(m_settings.audioSafeCpu, flStudioPid);
+        m_sensor.setAudioSafe(true);
+        LOG_DEBUG("🎙️ Recording: audio-safe mode on ({} priority, pinned to CPU {}), holding logs",
+                  !m_audioSafe.priorityLowered() ? "unchanged" : m_audioSafe.idlePriority() ? "idle" : "batch",
+                  m_audioSafe.pinnedCpu());
+        Logger::setDeferred(true);
+        return;
+    }
+    
+    m_audioSafe.leave();
+    m_sensor.setAudioSafe(false);
+    Logger::setDeferred(false);
+    if (m_audioSafe.priorityLowered()) {
+        LOG_DEBUG("🎙️ Recording stopped: audio-safe mode off, priority couldn't be restored");
+    } else {
+        LOG_DEBUG("🎙️ Recording stopped: audio-safe mode off");
+    }
+}
+
+void AppState::setPaused(bool paused) {
+    if (paused == m_paused) {
+        return;
+    }
+    m_paused = paused;
+    
+    if (paused && m_discord && m_discord->isConnected()) {
+        MemoryScope scope(MemoryStats::Subsystem::Discord);
+        m_discord->queueClearActivity();
+        m_staleness.queuedUnstamped();
+        m_staleness.sent(m_discord->flushQueue(m_arena));
+    }
+    // Whether pausing or resuming, Discord no longer shows m_lastActivity
+    m_lastActivity = DiscordActivity();
+    
+    LOG_DEBUG("{}", paused ? "⏸️ Presence paused" : "▶️ Presence resumed");
+}
+
 bool AppState::update() {
     if (m_shouldExit.load()) {
+        if (m_currentState.load() != State::STOPPED) {
+            stopMonitoring();
+            setState(State::STOPPED);
+            LOG_DEBUG("🚪 Application exit requested");
+            LOG_DEBUG("⏰ Wakeups per hour: {}", m_wakeups.stats(m_clock.now()).summary());
+        }
+        publishStatus();
         return false;
     }
     
-    State currentState = m_currentState.load();
+    m_wakeups.countTick();
+    applyPendingCommand();
     
-    if (currentState == State::MONITORING) {
-        // Check if FL Studio is still running
-        if (m_monitor->searchForFLStudio()) {
-            // FL Studio is running, update Discord activity
-            if (m_discord && m_discord->isConnected()) {
-                updateDiscordActivity();
-            } else {
-                // Try to reconnect
-                if (m_discord && m_discord->connect()) {
-                    if (m_debugMode.load()) {
-                        std::cout << "✅ Reconnected to Discord" << std::endl;
-                    }
-                } else if (m_debugMode.load()) {
-                    std::cout << "❌ Failed to connect to Discord" << std::endl;
-                }
-            }
+    if (!m_settings.memoryStats) {
+        tick();
+        m_arena.reset();
+        m_wakeups.setMode(pollMode(), m_clock.now());
+        publishStatus();
+        return true;
+    }
+    
+    m_memory.beginTick();
+    tick();
+    m_arena.reset();
+    m_wakeups.setMode(pollMode(), m_clock.now());
+    publishStatus();
+    uint64_t allocations = m_memory.endTick();
+    
+    if (m_memory.inSteadyState() && allocations > 0) {
+        LOG_WARN("⚠️ Steady-state tick allocated {} times", allocations);
+    }
+    // Building the report allocates, so only when it will be written
+    if (m_memory.ticks() % MEMORY_REPORT_TICKS == 0 && Logger::enabled(LogLevel::Debug)) {
+        logReport(getMemoryReport());
+    }
+    
+    return true;
+}
+
+void AppState::tick() {
+    TraceScope trace(Tracer::Span::Tick);
+    if (m_currentState.load() != State::MONITORING) {
+        return;
+    }
+    
+    // Latest scan from the sensor thread; ticks between scans reuse it
+    m_sensor.scanIfDue();
+    bool freshScan = m_sensor.update();
+    const SensorSnapshot& sensed = m_sensor.latest();
+    if (freshScan) {
+        m_staleness.observe(sensed);
+        m_wakeups.countScans(sensed.sequence - m_lastScanSequence);
+        m_lastScanSequence = sensed.sequence;
+        setAudioSafe(m_settings.audioSafe && sensed.flStudioRunning && sensed.state == PresenceState::Recording,
+                     sensed.flStudioPid);
+    }
+    
+    if (sensed.flStudioRunning) {
+        if (freshScan) {
+            LOG_DEBUG("Found FL Studio running...");
+        }
+        if (m_sessionStartTime == 0) {
+            m_sessionStartTime = m_clock.unixTime();
+        }
+    } else if (m_sessionStartTime != 0) {
+        // FL Studio exited - clear presence but keep the connection warm for its next launch
+        LOG_DEBUG("FL Studio not running - clearing Discord presence");
+        endSession();
+    }
+    
+    // Connected from startup on, whether or not FL Studio is running, so a
+    // launch only costs a SET_ACTIVITY rather than a connect and handshake
+    if (!m_discord) {
+        m_discord = std::make_unique<DiscordRPC>(m_settings.discordId, m_settings.discordTimeouts,
+                                                 m_settings.presenceFormat, m_clock);
+    }
+    
+    if (m_discord->isConnected()) {
+        processDiscordResponses();
+    }
+    
+    if (m_discord->isConnected()) {
+        if (m_paused || !sensed.flStudioRunning) {
+            // Keep sending what was queued before (a clear in particular)
+            MemoryScope scope(MemoryStats::Subsystem::Discord);
+            m_staleness.sent(m_discord->flushQueue(m_arena));
         } else {
-            // FL Studio not running - clear activity but keep monitoring
-            if (m_discord && m_discord->isConnected()) {
-                m_discord->clearActivity();
-                if (m_debugMode.load()) {
-                    std::cout << "🔌 FL Studio not running - cleared Discord activity" << std::endl;
-                }
-            }
+            updateDiscordActivity(sensed);
         }
-    } else if (currentState == State::DISCONNECTED) {
+    } else if (m_audioSafe.active()) {
+        // Reconnect probes wait until recording stops
+    } else if (!m_connector.attemptDue()) {
+        // Backing off after a failed attempt
+    } else if (connectDiscord()) {
+        LOG_DEBUG("✅ Connected to Discord!");
+    } else if (m_connector.waitingForEndpoint()) {
+        LOG_DEBUG("❌ Failed to connect to Discord. Waiting for Discord to start...");
+    } else {
+        LOG_DEBUG("❌ Failed to connect to Discord. Is Discord running? Retrying in {}ms", m_connector.retryDelayMs());
+    }
+}
 
+void AppState::waitForNextTick() {
+    // A request posted during this iteration (e.g. from the tray) is applied right away
+    if (m_shouldExit.load() || m_pendingCommand.load() != Command::NONE) {
+        return;
     }
     
-    return true;
+    int delayMs = nextTickDelayMs();
+    if (m_sensor.scansInline()) {
+        // Simulated time: the sensor's next scan is due on this thread too
+        delayMs = std::min(delayMs, m_sensor.msUntilNextScan());
+    }
+    if (m_wakeups.mode() == PollMode::DiscordDown) {
+        // Wake for the connector's next attempt or as soon as Discord creates its endpoint
+        m_connector.waitForEndpoint(delayMs, m_wakeup);
+    } else {
+        m_clock.wait(m_wakeup, delayMs);
+    }
+}
+
+int AppState::nextTickDelayMs() const {
+    const PollPolicy& policy = m_settings.pollPolicy;
+    switch (m_wakeups.mode()) {
+        case PollMode::Absent:
+            // Nothing to do until the sensor sees FL Studio start (or a request comes in)
+            return policy.absentMaxMs;
+        case PollMode::DiscordDown: {
+            // The connector backs off; a new endpoint cuts the wait short
+            long long retryMs = m_connector.waitingForEndpoint() ? policy.absentMaxMs : m_connector.retryDelayMs();
+            return static_cast<int>(std::min<long long>(retryMs, policy.absentMaxMs));
+        }
+        case PollMode::Idle:
+        case PollMode::Recording:
+            return policy.idleMs;
+        case PollMode::Active:
+        case PollMode::Count:
+            break;
+    }
+    return policy.activeMs;
 }
 
 void AppState::requestExit() {
     m_shouldExit.store(true);
-    stopMonitoring();
-    
-    if (m_debugMode.load()) {
-        std::cout << "🚪 Application exit requested" << std::endl;
+    m_wakeup.signal();
+}
+
+std::string AppState::getMemoryReport() const {
+    return m_memory.report() +
+        "  Tick arena: " + std::to_string(m_arena.highWater()) + "/" +
+        std::to_string(m_arena.capacity()) + " bytes high water, " +
+        std::to_string(m_arena.overflowCount()) + " overflows\n";
+}
+
+std::string AppState::getLatencyReport() const {
+    if (!m_discord || m_discord->connectLatencies().count() == 0) {
+        return "";
     }
+    return "Discord latency:\n"
+        "  Connect: " + m_discord->connectLatencies().summary() + "\n"
+        "  Requests: " + m_discord->requestLatencies().summary() + ", " +
+        std::to_string(m_discord->timedOutRequestCount()) + " timed out, " +
+        std::to_string(m_discord->droppedUpdateCount()) + " dropped while queued\n" +
+        m_staleness.report();
 }
 
 std::string AppState::getStatusString() const {
-    State state = m_currentState.load();
+    Status status = getStatus();
     
-    switch (state) {
+    switch (status.state) {
         case State::STOPPED:
             return "Stopped";
             
         case State::MONITORING:
-            if (m_discord && m_discord->isConnected()) {
+            if (status.discordConnected) {
                 return "Connected - Monitoring FL Studio";
             } else {
                 return "Monitoring FL Studio (Discord disconnected)";
@@ -185,32 +379,91 @@ void AppState::setState(State newState) {
     m_currentState.store(newState);
 }
 
-bool AppState::initializeDiscord() {
+PollMode AppState::pollMode() const {
+    const SensorSnapshot& sensed = m_sensor.latest();
+    if (m_currentState.load() != State::MONITORING) {
+        return PollMode::Absent;
+    }
+    if (m_audioSafe.active()) {
+        return PollMode::Recording;
+    }
+    // The connection is kept up with or without FL Studio
+    if (!m_discord || !m_discord->isConnected()) {
+        return PollMode::DiscordDown;
+    }
+    if (!sensed.flStudioRunning) {
+        return PollMode::Absent;
+    }
+    // A queued update goes out on a later tick, so it gets the tighter interval too
+    if (m_paused || (sensed.state == PresenceState::Idle && !m_discord->hasQueuedUpdate())) {
+        return PollMode::Idle;
+    }
+    return PollMode::Active;
+}
+
+void AppState::publishStatus() {
+    Status status;
+    status.state = m_currentState.load();
+    status.flStudioRunning = status.state == State::MONITORING && m_sensor.latest().flStudioRunning;
+    if (status.flStudioRunning) {
+        status.flStudioUsage = m_sensor.latest().flStudioUsage;
+    }
+    status.discordConnected = m_discord && m_discord->isConnected();
+    status.paused = m_paused;
+    status.audioSafe = m_audioSafe.active();
+    status.sessionStartTime = m_sessionStartTime;
+    status.lastUpdateTime = m_lastUpdateTime;
+    status.activity = m_lastActivity;
+    status.updatesSent = m_coalescer.sentUpdates();
+    status.updatesMerged = m_coalescer.mergedUpdates();
+    status.updatesDropped = m_droppedBefore + (m_discord ? m_discord->droppedUpdateCount() : 0);
+    status.requestsTimedOut = m_timedOutBefore + (m_discord ? m_discord->timedOutRequestCount() : 0);
+    status.scriptToParse = m_staleness.scriptToParse();
+    status.parseToAck = m_staleness.parseToAck();
+    status.scriptToAck = m_staleness.scriptToAck();
+    status.pollMode = m_wakeups.mode();
+    
+    // Wakeup counters alone republish the status once a second, not every tick
+    Clock::TimePoint now = m_clock.now();
+    bool refreshWakeups = now - m_wakeupsPublishedAt >= std::chrono::milliseconds(WAKEUPS_REFRESH_MS);
+    status.wakeups = refreshWakeups ? m_wakeups.stats(now) : m_status.wakeups;
+    
+    // A publish that found no free slot is retried next tick
+    if ((refreshWakeups || status != m_status) && m_publishedStatus.publish(status)) {
+        m_status = status;
+        if (refreshWakeups) {
+            m_wakeupsPublishedAt = now;
+        }
+    }
+}
+
+bool AppState::connectDiscord() {
+    MemoryScope scope(MemoryStats::Subsystem::Discord);
+    
     try {
-        m_discord = std::make_unique<DiscordRPC>(m_discordId);
-        
-        if (m_discord->connect()) {
+        bool connected = m_discord->connect(m_connector, m_arena);
+        m_connector.recordResult(connected);
+        if (connected) {
+            if (m_paused || m_sessionStartTime == 0) {
+                // Stay connected, but show nothing until resumed or FL Studio starts
+                return true;
+            }
+            
             // Set initial activity
             DiscordActivity activity;
-            activity.state = "Starting up...";
-            activity.details = "FL Studio";
-            activity.largeImage = "fl_studio_logo";
-            activity.largeText = "FL Studio";
-            activity.smallImage = "idle";
+            activity.state = PresenceState::Starting;
             activity.startTime = m_sessionStartTime;
             
-            m_discord->updateActivity(activity);
-            
-            if (m_debugMode.load()) {
-                std::cout << "✅ Discord RPC initialized and connected" << std::endl;
-            }
-            
+            // Don't wait for the response; it is picked up on the next tick
+            m_discord->queueActivity(activity, PresencePriority::State);
+            m_staleness.queuedUnstamped();
+            m_staleness.sent(m_discord->flushQueue(m_arena));
+            m_lastActivity = activity;
+            m_lastUpdateTime = m_clock.unixTime();
             return true;
         }
     } catch (const std::exception& e) {
-        if (m_debugMode.load()) {
-            std::cout << "❌ Discord RPC initialization failed: " << e.what() << std::endl;
-        }
+        LOG_ERROR("❌ Discord RPC initialization failed: {}", e.what());
     }
     
     return false;
@@ -218,54 +471,113 @@ bool AppState::initializeDiscord() {
 
 void AppState::cleanupDiscord() {
     if (m_discord) {
+        if (m_discord->connectLatencies().count() > 0 && Logger::enabled(LogLevel::Debug)) {
+            logReport(getLatencyReport());
+        }
         if (m_discord->isConnected()) {
-            m_discord->clearActivity();
+            m_discord->clearActivity(m_arena);
             m_discord->disconnect();
         }
+        m_droppedBefore += m_discord->droppedUpdateCount();
+        m_timedOutBefore += m_discord->timedOutRequestCount();
         m_discord.reset();
+        m_staleness.forgetInFlight();
     }
+    m_arena.reset();
 }
 
-bool AppState::updateDiscordActivity() {
+void AppState::endSession() {
+    if (m_discord && m_discord->isConnected() && !m_paused) {
+        // Sent by this tick's flush, after any response processing
+        MemoryScope scope(MemoryStats::Subsystem::Discord);
+        m_discord->queueClearActivity();
+        m_staleness.queuedUnstamped();
+    }
+    m_lastActivity = DiscordActivity();
+    m_sessionStartTime = 0;
+}
+
+void AppState::processDiscordResponses() {
+    MemoryScope scope(MemoryStats::Subsystem::Discord);
+    
+    if (!m_discord->pollResponses(m_arena)) {
+        // Dead link noticed (EOF, reset, unanswered ping); tick() reconnects right away
+        LOG_DEBUG("🔌 Lost Discord connection: {}", m_discord->lastDisconnectReason());
+        return;
+    }
+    
+    DiscordResponse response;
+    while (m_discord->nextResponse(response)) {
+        if (response.ok) {
+            m_staleness.acknowledged(response.nonce, m_clock.unixTimeMs());
+            continue;
+        }
+        
+        // Forget what we think Discord shows so the next tick sends it again
+        m_lastActivity = DiscordActivity();
+        
+        LOG_WARN("❌ Discord rejected request {}: {} (code {})",
+                 response.nonce, response.errorMessage.view(), response.errorCode);
+    }
+}
+
+bool AppState::updateDiscordActivity(const SensorSnapshot& sensed) {
     if (!m_discord || !m_discord->isConnected()) {
         return false;
     }
     
     try {
-        FLStudioData data = FLParser::getData(m_stateFilePath);
-        
+        MemoryScope scope(MemoryStats::Subsystem::Presence);
         DiscordActivity activity;
-        activity.state = std::to_string(data.bpm) + " BPM";
-        activity.details = data.state;
-        
-        if (!data.plugin.empty()) {
-            activity.details += " • " + data.plugin;
-        }
-        
-        
-        std::string lowerState = data.state;
-        std::transform(lowerState.begin(), lowerState.end(), lowerState.begin(), ::tolower);
-        activity.smallImage = lowerState;
-        activity.largeImage = "fl_studio_logo";
-        activity.largeText = "FL Studio";
+        activity.state = sensed.state;
+        activity.bpm = sensed.bpm;
+        activity.plugin = sensed.plugin;
+        activity.projectName = sensed.projectName;
         activity.startTime = m_sessionStartTime;
+        // Usage changes every sample; only a template that shows it should send an update for it
+        if (m_settings.presenceFormat.showsUsage()) {
+            activity.cpuPercent = sensed.flStudioUsage.cpuPercent;
+            activity.memoryMb = static_cast<int>(sensed.flStudioUsage.rssBytes >> 20);
+        }
         
-        bool success = m_discord->updateActivity(activity);
-        
-        if (m_debugMode.load() && success) {
-            std::cout << "✅ Rich Presence updated: " << data.state << " @ " << data.bpm << " BPM";
-            if (!data.plugin.empty()) {
-                std::cout << " (" << data.plugin << ")";
+        // Unchanged, or still settling (BPM and plugin changes wait out their window)
+        bool changed;
+        {
+            TraceScope trace(Tracer::Span::Diff);
+            changed = m_coalescer.shouldSend(activity, m_lastActivity, m_clock.now());
+        }
+        // While recording only state changes are worth a socket write; details catch up afterwards
+        if (m_audioSafe.active() && activity.state == m_lastActivity.state) {
+            changed = false;
+        }
+        if (changed) {
+            // Latest wins: replaces a queued update, and a state change doesn't
+            // wait behind a detail update Discord hasn't answered yet
+            PresencePriority priority = activity.state != m_lastActivity.state
+                ? PresencePriority::State
+                : PresencePriority::Detail;
+            m_discord->queueActivity(activity, priority);
+            m_staleness.queued(sensed);
+            m_lastActivity = activity;
+            m_lastUpdateTime = m_clock.unixTime();
+            m_coalescer.markSent();
+            
+            if (activity.plugin.empty()) {
+                LOG_DEBUG("✅ Rich Presence updated: {} @ {} BPM [{} merged]",
+                          presenceStateName(activity.state), activity.bpm, m_coalescer.mergedUpdates());
+            } else {
+                LOG_DEBUG("✅ Rich Presence updated: {} @ {} BPM ({}) [{} merged]",
+                          presenceStateName(activity.state), activity.bpm, activity.plugin.view(), m_coalescer.mergedUpdates());
             }
-            std::cout << std::endl;
         }
         
-        return success;
+        // Sent without waiting; the response is matched by nonce on a later tick
+        MemoryScope discordScope(MemoryStats::Subsystem::Discord);
+        m_staleness.sent(m_discord->flushQueue(m_arena));
+        return m_discord->isConnected();
         
     } catch (const std::exception& e) {
-        if (m_debugMode.load()) {
-            std::cout << "❌ Failed to update Discord activity: " << e.what() << std::endl;
-        }
+        LOG_ERROR("❌ Failed to update Discord activity: {}", e.what());
         return false;
     }
 }
\ No newline at end of file
@@ -4,16 +4,53 @@
 #include <string>
 #include <atomic>
 #include <memory>
+#include "memory_stats.h"
+#include "arena.h"
+#include "discord_rp.h"
+#include "coalescer.h"
+#include "sensor.h"
+#include "staleness.h"
+#include "audio_safe.h"
+#include "atomic_snapshot.h"
 
-// Forward declarations
-class DiscordRPC;
-class ProcessMonitor;
+/**
+ * @brief Runtime settings, loaded from .env by main
+ */
+struct AppSettings {
+    std::string stateFilePath;
+    std::string discordId;
+    PollPolicy pollPolicy;
+    bool debugMode;
+    bool memoryStats;
+    std::string controlSocket;        // Control socket path, empty to disable
+    bool traceEnabled;                // Record spans from startup, written at exit
+    std::string traceFile;
+    bool audioSafe;                   // Lower priority and defer work while FL Studio records
+    int audioSafeCpu;                 // CPU to pin to while recording, -1 for the one FL Studio uses least
+    DiscordTimeouts discordTimeouts;
+    CoalescePolicy coalescePolicy;
+    PresenceFormat presenceFormat;    // Activity text templates
+    ProcessMatcher processMatcher;    // Process names that count as FL Studio
+    
+    AppSettings()
+        : discordId("1396127471342194719")
+        , debugMode(false)
+        , memoryStats(false)
+        , traceEnabled(false)
+        , traceFile("flrp-trace.json")
+        , audioSafe(true)
+        , audioSafeCpu(-1) {}
+};
 
 /**
  * @brief Application state manager
  * 
  * Manages the overall state of the FL Studio Rich Presence application,
  * including Discord connection status and FL Studio monitoring state.
+ *
+ * update() and everything it touches run on a single thread. Other threads
+ * (tray, front-ends) read getStatus() and post requests with the
+ * request*() methods; neither blocks the update loop.
  */
 class AppState {
 public:
@@ -22,27 +59,109 @@ public:
         MONITORING,     // Monitoring FL Studio, Discord connected
         DISCONNECTED    // Monitoring stopped, Discord disconnected
     };
+    
+    /**
+     * @brief Point-in-time view of the application, published after every update()
+     */
+    struct Status {
+        State state;
+        bool flStudioRunning;
+        ProcessUsage flStudioUsage;     // Sampled CPU and memory use while FL Studio runs
+        bool discordConnected;
+        bool paused;                    // Presence hidden until resumed; Discord stays connected
+        bool audioSafe;                 // FL Studio is recording; the daemon keeps out of its way
+        long long sessionStartTime;     // Unix seconds, 0 outside an FL Studio session
+        long long lastUpdateTime;       // Unix seconds when an activity was last sent, 0 if never
+        DiscordActivity activity;       // Activity last sent to Discord
+        uint64_t updatesSent;
+        uint64_t updatesMerged;         // Changes folded into a later update by the coalescer
+        uint64_t updatesDropped;        // Queued updates replaced before they were sent
+        uint64_t requestsTimedOut;
+        LatencySummary scriptToParse;   // State file staleness, see StalenessTracker
+        LatencySummary parseToAck;
+        LatencySummary scriptToAck;
+        PollMode pollMode;
+        WakeupStats wakeups;            // Refreshed at most every WAKEUPS_REFRESH_MS, see operator==
+        
+        Status()
+            : state(State::STOPPED), flStudioRunning(false), discordConnected(false), paused(false), audioSafe(false)
+            , sessionStartTime(0), lastUpdateTime(0)
+            , updatesSent(0), updatesMerged(0), updatesDropped(0), requestsTimedOut(0)
+            , pollMode(PollMode::Absent) {}
+        
+        // Leaves out wakeups: they change every tick, so comparing them would
+        // republish an otherwise unchanged status on every update()
+        bool operator==(const Status& other) const {
+            return state == other.state && flStudioRunning == other.flStudioRunning &&
+                   flStudioUsage == other.flStudioUsage && discordConnected == other.discordConnected && paused == other.paused &&
+                   audioSafe == other.audioSafe &&
+                   sessionStartTime == other.sessionStartTime && lastUpdateTime == other.lastUpdateTime &&
+                   activity == other.activity && updatesSent == other.updatesSent &&
+                   updatesMerged == other.updatesMerged && updatesDropped == other.updatesDropped &&
+                   requestsTimedOut == other.requestsTimedOut && scriptToParse == other.scriptToParse &&
+                   parseToAck == other.parseToAck && scriptToAck == other.scriptToAck &&
+                   pollMode == other.pollMode;
+        }
+        bool operator!=(const Status& other) const { return !(*this == other); }
+    };
 
 private:
+    // Ticks between memory reports in memory stats mode
+    static const uint64_t MEMORY_REPORT_TICKS = 60;
+    
+    // Wakeup counters in the published status are at most this old
+    static const int WAKEUPS_REFRESH_MS = 1000;
+    
+    // Requests posted from other threads, applied at the start of update()
+    enum class Command : uint8_t {
+        NONE,
+        REFRESH,
+        DISCONNECT,
+        PAUSE,
+        RESUME
+    };
+    
     std::atomic<State> m_currentState;
     std::atomic<bool> m_shouldExit;
     std::atomic<bool> m_debugMode;
+    std::atomic<Command> m_pendingCommand;
+    WakeEvent m_wakeup;               // Cuts waitForNextTick() short: requests, FL Studio starting or stopping
+    
+    // Published for other threads; m_status is the update thread's copy of the latest
+    AtomicSnapshot<Status> m_publishedStatus;
+    Status m_status;
+    Clock::TimePoint m_wakeupsPublishedAt;
+    long long m_lastUpdateTime;
+    uint64_t m_droppedBefore;         // Counters of Discord connections already closed
+    uint64_t m_timedOutBefore;
     
     // Configuration
-    std::string m_stateFilePath;
-    int m_pollInterval;
-    std::string m_discordId;
+    AppSettings m_settings;
     
     // Runtime objects
+    Clock& m_clock;                   // Every timestamp, timeout and wait below; simulations pass their own
     std::unique_ptr<DiscordRPC> m_discord;
-    std::unique_ptr<ProcessMonitor> m_monitor;
+    IpcConnector m_connector;         // Endpoint memory and reconnect backoff, kept across sessions
+    Sensor m_sensor;                  // Scans for FL Studio and reads the state file on its own thread
     long long m_sessionStartTime;
+    bool m_paused;                    // Presence cleared and not updated until resume
+    AudioSafeMode m_audioSafe;        // Priority and affinity while FL Studio records
+    DiscordActivity m_lastActivity;   // Last activity Discord accepted
+    PresenceCoalescer m_coalescer;    // Debounces BPM/plugin changes before they reach Discord
+    StalenessTracker m_staleness;     // write_time to parse to Discord ack
+    WakeupCounter m_wakeups;          // Poll mode and wakeups per mode
+    uint64_t m_lastScanSequence;      // Sensor scans already counted
+    MemoryTracker m_memory;
+    
+    // Per-tick scratch memory for parsing, presence text and Discord frames
+    TickArena m_arena;
 
 public:
     /**
      * @brief Constructor
+     * @param clock Time source; a SimulatedClock runs the loop without real waits
      */
-    AppState();
+    explicit AppState(Clock& clock = Clock::system());
     
     /**
      * @brief Destructor
@@ -51,31 +170,56 @@ public:
     
     /**
      * @brief Initialize application state with configuration
-     * @param stateFile Path to FL Studio state file
-     * @param pollInterval Polling interval in milliseconds
-     * @param debugMode Whether debug mode is enabled
+     * @param settings Settings loaded from .env
      * @return true if successful, false otherwise
      */
-    bool initialize(const std::string& stateFile, int pollInterval, bool debugMode);
+    bool initialize(const AppSettings& settings);
     
     /**
-     * @brief Start monitoring FL Studio and connect to Discord
+     * @brief Start monitoring FL Studio
+     * The first update() connects to Discord; the connection then stays
+     * up across FL Studio sessions, which only set and clear the activity.
      * @return true if successful, false otherwise
      */
     bool startMonitoring();
     
     /**
      * @brief Stop monitoring and disconnect from Discord
+     * No reconnection is attempted until refreshConnection() is called.
+     * Update thread only; other threads use requestDisconnect().
      * @return true if successful, false otherwise
      */
     bool stopMonitoring();
     
     /**
      * @brief Refresh Discord connection (disconnect and reconnect)
+     * Also resumes monitoring after stopMonitoring().
+     * Update thread only; other threads use requestRefresh().
      * @return true if successful, false otherwise
      */
     bool refreshConnection();
     
+    /**
+     * @brief Ask the update thread to refresh the Discord connection (any thread)
+     */
+    void requestRefresh();
+    
+    /**
+     * @brief Ask the update thread to stop monitoring and disconnect (any thread)
+     */
+    void requestDisconnect();
+    
+    /**
+     * @brief Ask the update thread to clear the presence and stop updating it (any thread)
+     * Unlike a disconnect, monitoring continues and the session timer keeps running.
+     */
+    void requestPause();
+    
+    /**
+     * @brief Ask the update thread to show the presence again after requestPause() (any thread)
+     */
+    void requestResume();
+    
     /**
      * @brief Perform one monitoring cycle
      * Should be called regularly from main loop
@@ -84,7 +228,17 @@ public:
     bool update();
     
     /**
-     * @brief Request application exit
+     * @brief Wait until the next update() is due under the current poll mode
+     * Active sessions use the tighter interval, idle ones POLL_INTERVAL_MS.
+     * Without FL Studio, waits until the sensor sees it start; without
+     * Discord, until the next connect attempt or a new endpoint. Returns
+     * early for a request, and right away when one is already pending.
+     */
+    void waitForNextTick();
+    
+    /**
+     * @brief Request application exit (any thread)
+     * The next update() shuts down and returns false
      */
     void requestExit();
     
@@ -107,10 +261,28 @@ public:
     bool isDebugMode() const { return m_debugMode.load(); }
     
     /**
-     * @brief Get current status string for display
+     * @brief Get the status published by the last update() (any thread, never blocks)
+     * @return Copy of the latest status
+     */
+    Status getStatus() const { return m_publishedStatus.load(); }
+    
+    /**
+     * @brief Get current status string for display (any thread)
      * @return Status string describing current state
      */
     std::string getStatusString() const;
+    
+    /**
+     * @brief Get memory usage report (RSS, heap, allocations per tick)
+     * @return Multi-line report string
+     */
+    std::string getMemoryReport() const;
+    
+    /**
+     * @brief Get Discord connect and request latency summaries, plus state file staleness
+     * @return Multi-line report string, empty if Discord hasn't connected this session
+     */
+    std::string getLatencyReport() const;
 
 private:
     /**
@@ -120,10 +292,58 @@ private:
     void setState(State newState);
     
     /**
-     * @brief Initialize Discord RPC connection
+     * @brief Poll mode for the state after this update
+     */
+    PollMode pollMode() const;
+    
+    /**
+     * @brief How long waitForNextTick() waits under the current poll mode
+     */
+    int nextTickDelayMs() const;
+    
+    /**
+     * @brief Monitoring cycle body, bracketed by memory accounting in update()
+     */
+    void tick();
+    
+    /**
+     * @brief Apply a request posted by another thread
+     */
+    void applyPendingCommand();
+    
+    /**
+     * @brief Clear the presence and stop updating it, or start showing it again
+     */
+    void setPaused(bool paused);
+    
+    /**
+     * @brief Enter or leave audio-safe mode as FL Studio starts or stops recording
+     * While recording the process runs at idle priority pinned to a CPU
+     * FL Studio isn't busy on, logs are held, reconnect attempts wait and
+     * only state changes are sent to Discord.
+     */
+    void setAudioSafe(bool recording, uint32_t flStudioPid);
+    
+    /**
+     * @brief Publish a new status snapshot if anything changed since the last one
+     */
+    void publishStatus();
+    
+    /**
+     * @brief Connect to Discord and set the initial activity
      * @return true if successful, false otherwise
      */
-    bool initializeDiscord();
+    bool connectDiscord();
+    
+    /**
+     * @brief FL Studio exited: queue a clear and forget the session, keeping the connection
+     */
+    void endSession();
+    
+    /**
+     * @brief Read responses to earlier requests and handle errors
+     */
+    void processDiscordResponses();
     
     /**
      * @brief Clean up Discord RPC connection
@@ -132,9 +352,10 @@ private:
     
     /**
      * @brief Update Discord Rich Presence with current FL Studio data
+     * @param sensed Latest scan from the sensor thread
      * @return true if successful, false otherwise
      */
-    bool updateDiscordActivity();
+    bool updateDiscordActivity(const SensorSnapshot& sensed);
 };
 
 #endif // APP_STATE_H
\ No newline at end of file
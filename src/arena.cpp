@@ -0,0 +1,112 @@
+#include "arena.h"
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+TickArena::TickArena(size_t capacity)
+    : m_block(static_cast<char*>(std::malloc(capacity)))
+    , m_capacity(m_block ? capacity : 0)
+    , m_used(0)
+    , m_highWater(0)
+    , m_lastOffset(0)
+    , m_overflow(nullptr)
+    , m_overflowCount(0) {
+}
+
+TickArena::~TickArena() {
+    reset();
+    std::free(m_block);
+}
+
+void* TickArena::allocate(size_t size, size_t alignment) {
+    size_t offset = (m_used + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= m_capacity) {
+        m_lastOffset = offset;
+        m_used = offset + size;
+        if (m_used > m_highWater) {
+            m_highWater = m_used;
+        }
+        return m_block + offset;
+    }
+
+    // Doesn't fit: heap block with a list header, freed on reset
+    size_t header = (sizeof(Overflow) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    void* raw = std::malloc(header + size);
+    if (!raw) {
+        throw std::bad_alloc();
+    }
+    Overflow* node = static_cast<Overflow*>(raw);
+    node->next = m_overflow;
+    m_overflow = node;
+    m_overflowCount++;
+    return static_cast<char*>(raw) + header;
+}
+
+bool TickArena::extend(void* p, size_t oldSize, size_t newSize) {
+    char* c = static_cast<char*>(p);
+    if (c != m_block + m_lastOffset || m_lastOffset + oldSize != m_used) {
+        return false;
+    }
+    if (m_lastOffset + newSize > m_capacity) {
+        return false;
+    }
+    m_used = m_lastOffset + newSize;
+    if (m_used > m_highWater) {
+        m_highWater = m_used;
+    }
+    return true;
+}
+
+std::string_view TickArena::copy(std::string_view text) {
+    char* dst = allocateChars(text.size());
+    std::memcpy(dst, text.data(), text.size());
+    return std::string_view(dst, text.size());
+}
+
+void TickArena::reset() {
+    while (m_overflow) {
+        Overflow* next = m_overflow->next;
+        std::free(m_overflow);
+        m_overflow = next;
+    }
+    m_used = 0;
+    m_lastOffset = 0;
+}
+
+ArenaWriter::ArenaWriter(TickArena& arena, size_t initialCapacity)
+    : m_arena(arena)
+    , m_data(arena.allocateChars(initialCapacity))
+    , m_size(0)
+    , m_capacity(initialCapacity) {
+}
+
+void ArenaWriter::grow(size_t minCapacity) {
+    size_t newCapacity = m_capacity * 2;
+    if (newCapacity < minCapacity) {
+        newCapacity = minCapacity;
+    }
+    if (m_arena.extend(m_data, m_capacity, newCapacity)) {
+        m_capacity = newCapacity;
+        return;
+    }
+    char* moved = m_arena.allocateChars(newCapacity);
+    std::memcpy(moved, m_data, m_size);
+    m_data = moved;
+    m_capacity = newCapacity;
+}
+
+ArenaWriter& ArenaWriter::operator+=(std::string_view text) {
+    if (m_size + text.size() > m_capacity) {
+        grow(m_size + text.size());
+    }
+    std::memcpy(m_data + m_size, text.data(), text.size());
+    m_size += text.size();
+    return *this;
+}
+
+void ArenaWriter::appendInt(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    *this += std::string_view(digits, static_cast<size_t>(result.ptr - digits));
+}
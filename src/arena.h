@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Monotonic scratch allocator for one loop iteration
+ *
+ * Memory is handed out by bumping an offset into a block allocated once at
+ * startup and released all at once by reset() at the end of the tick. Requests
+ * that don't fit fall back to the heap until the next reset; they are counted
+ * so the block can be sized to avoid them.
+ */
+class TickArena {
+    private:
+        struct Overflow {
+            Overflow* next;
+        };
+
+        char* m_block;
+        size_t m_capacity;
+        size_t m_used;
+        size_t m_highWater;
+        size_t m_lastOffset;
+        Overflow* m_overflow;
+        uint64_t m_overflowCount;
+
+    public:
+        static const size_t DEFAULT_CAPACITY = 64 * 1024;
+
+        explicit TickArena(size_t capacity = DEFAULT_CAPACITY);
+        ~TickArena();
+
+        TickArena(const TickArena&) = delete;
+        TickArena& operator=(const TickArena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+        char* allocateChars(size_t count) { return static_cast<char*>(allocate(count, 1)); }
+
+        /**
+         * @brief Grow the most recent allocation in place if it is at the top of the block
+         * @return true if the allocation now spans newSize bytes
+         */
+        bool extend(void* p, size_t oldSize, size_t newSize);
+
+        /**
+         * @brief Copy text into the arena
+         * @return View of the copy, valid until reset()
+         */
+        std::string_view copy(std::string_view text);
+
+        /**
+         * @brief Release everything allocated since the last reset
+         */
+        void reset();
+
+        size_t used() const { return m_used; }
+        size_t capacity() const { return m_capacity; }
+        size_t highWater() const { return m_highWater; }
+        uint64_t overflowCount() const { return m_overflowCount; }
+};
+
+/**
+ * @brief Append-only text buffer carved out of a TickArena
+ *
+ * Grows in place while it is the newest allocation, otherwise moves to a
+ * larger region. The contents are valid until the arena is reset.
+ */
+class ArenaWriter {
+    private:
+        TickArena& m_arena;
+        char* m_data;
+        size_t m_size;
+        size_t m_capacity;
+
+        void grow(size_t minCapacity);
+
+    public:
+        ArenaWriter(TickArena& arena, size_t initialCapacity = 256);
+
+        ArenaWriter& operator+=(char c) {
+            if (m_size == m_capacity) grow(m_size + 1);
+            m_data[m_size++] = c;
+            return *this;
+        }
+
+        ArenaWriter& operator+=(std::string_view text);
+
+        void appendInt(long long value);
+
+        /**
+         * @brief Drop everything after the first size bytes
+         */
+        void truncate(size_t size) {
+            if (size < m_size) m_size = size;
+        }
+
+        char* data() { return m_data; }
+        size_t size() const { return m_size; }
+        std::string_view view() const { return std::string_view(m_data, m_size); }
+};
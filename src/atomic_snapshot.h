@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Immutable value published by one writer thread and read by any number of readers
+ *
+ * The writer copies each new value into a free slot and swaps the slot
+ * pointer in; a published slot is never written again until it has been
+ * replaced and no reader holds it. Readers pin the current slot with a
+ * reference count and copy it out, retrying if it was replaced in between,
+ * so neither side takes a lock. Slots are preallocated: publishing never
+ * allocates.
+ *
+ * SLOTS bounds how many readers can copy at the same time without the
+ * writer running out of free slots; publish() fails instead of waiting.
+ */
+template <typename T, int SLOTS = 4>
+class AtomicSnapshot {
+    private:
+        struct alignas(64) Slot {
+            T value;
+            std::atomic<uint32_t> readers;
+
+            Slot() : value(), readers(0) {}
+        };
+
+        Slot m_slots[SLOTS];
+        std::atomic<Slot*> m_current;
+
+    public:
+        AtomicSnapshot() : m_current(&m_slots[0]) {}
+
+        AtomicSnapshot(const AtomicSnapshot&) = delete;
+        AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+
+        /**
+         * @brief Writer: replace the published value
+         * @return false if every other slot is still being read; try again later
+         */
+        bool publish(const T& value) {
+            Slot* current = m_current.load();
+            for (int i = 0; i < SLOTS; i++) {
+                Slot* slot = &m_slots[i];
+                if (slot == current || slot->readers.load() != 0) {
+                    continue;
+                }
+                // Not current and unpinned: a reader that pins it now sees
+                // it isn't current and lets go without reading
+                slot->value = value;
+                m_current.store(slot);
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Reader: copy of the latest published value (default-constructed before the first)
+         */
+        T load() const {
+            for (;;) {
+                Slot* slot = m_current.load();
+                slot->readers.fetch_add(1);
+                if (m_current.load() == slot) {
+                    T value = slot->value;
+                    slot->readers.fetch_sub(1);
+                    return value;
+                }
+                slot->readers.fetch_sub(1);
+            }
+        }
+};
@@ -0,0 +1,253 @@
+#include "audio_safe.h"
+
+#ifndef _WIN32
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+AudioSafeMode::AudioSafeMode()
+    : m_active(false)
+    , m_priorityLowered(false)
+    , m_idlePriority(false)
+    , m_pinnedCpu(-1) {
+#ifdef _WIN32
+    m_priorityClass = NORMAL_PRIORITY_CLASS;
+    m_affinity = 0;
+#else
+    m_policy = SCHED_OTHER;
+    CPU_ZERO(&m_affinity);
+#endif
+}
+
+AudioSafeMode::~AudioSafeMode() {
+    leave();
+}
+
+#ifdef _WIN32
+
+bool AudioSafeMode::priorityRestorable() {
+    return true;
+}
+
+void AudioSafeMode::enter(int cpu, uint32_t) {
+    if (m_active) {
+        return;
+    }
+    m_active = true;
+
+    HANDLE process = GetCurrentProcess();
+    m_priorityClass = GetPriorityClass(process);
+    m_priorityLowered = SetPriorityClass(process, IDLE_PRIORITY_CLASS) != 0;
+    m_idlePriority = m_priorityLowered;
+    // Background mode also lowers I/O and memory priority
+    SetPriorityClass(process, PROCESS_MODE_BACKGROUND_BEGIN);
+
+    DWORD_PTR systemMask = 0;
+    if (!GetProcessAffinityMask(process, &m_affinity, &systemMask)) {
+        return;
+    }
+    int last = -1;
+    for (int i = 0; i < static_cast<int>(sizeof(DWORD_PTR) * 8); i++) {
+        if (m_affinity & (static_cast<DWORD_PTR>(1) << i)) {
+            last = i;
+        }
+    }
+    bool allowed = cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8) &&
+                   (m_affinity & (static_cast<DWORD_PTR>(1) << cpu));
+    int target = allowed ? cpu : last;
+    // With a single CPU there is nothing to move away from
+    if (target >= 0 && m_affinity != (static_cast<DWORD_PTR>(1) << target) &&
+        SetProcessAffinityMask(process, static_cast<DWORD_PTR>(1) << target)) {
+        m_pinnedCpu = target;
+    }
+}
+
+void AudioSafeMode::leave() {
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+
+    HANDLE process = GetCurrentProcess();
+    SetPriorityClass(process, PROCESS_MODE_BACKGROUND_END);
+    if (m_priorityLowered) {
+        SetPriorityClass(process, m_priorityClass);
+        m_priorityLowered = false;
+        m_idlePriority = false;
+    }
+    if (m_pinnedCpu >= 0) {
+        SetProcessAffinityMask(process, m_affinity);
+        m_pinnedCpu = -1;
+    }
+}
+
+#else
+
+namespace {
+
+// Applies fn to every thread of this process: scheduling attributes are per thread
+template <typename Fn>
+void forEachThread(Fn fn) {
+    DIR* tasks = opendir("/proc/self/task");
+    if (!tasks) {
+        fn(0);  // The calling thread at least
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(tasks)) != nullptr) {
+        if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9') {
+            fn(static_cast<pid_t>(std::atoi(entry->d_name)));
+        }
+    }
+    closedir(tasks);
+}
+
+// CPU time (clock ticks) of pid's threads, added to the CPU each thread last ran on
+void addThreadTimesByCpu(uint32_t pid, unsigned long long* ticks) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%u/task", pid);
+    DIR* tasks = opendir(path);
+    if (!tasks) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(tasks)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        unsigned long tid = std::strtoul(entry->d_name, nullptr, 10);
+        std::snprintf(path, sizeof(path), "/proc/%u/task/%lu/stat", pid, tid);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        char buffer[1024];
+        ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (n <= 0) {
+            continue;
+        }
+        buffer[n] = '\0';
+
+        // Fields after the parenthesized name, which may itself hold spaces:
+        // state is field 3, utime 14, stime 15, processor 39
+        const char* field = std::strrchr(buffer, ')');
+        if (!field) {
+            continue;
+        }
+        unsigned long long time = 0;
+        long processor = -1;
+        for (int index = 3; index <= 39 && *field; index++) {
+            field = std::strchr(field, ' ');
+            if (!field) {
+                break;
+            }
+            field++;
+            if (index == 14 || index == 15) {
+                time += std::strtoull(field, nullptr, 10);
+            } else if (index == 39) {
+                processor = std::strtol(field, nullptr, 10);
+            }
+        }
+        if (processor >= 0 && processor < CPU_SETSIZE) {
+            ticks[processor] += time;
+        }
+    }
+    closedir(tasks);
+}
+
+// The allowed CPU avoidPid's threads have used least; ties go to the highest
+int quietestCpu(const cpu_set_t& allowed, uint32_t avoidPid) {
+    unsigned long long ticks[CPU_SETSIZE] = {};
+    if (avoidPid != 0) {
+        addThreadTimesByCpu(avoidPid, ticks);
+    }
+    int quietest = -1;
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &allowed) && (quietest < 0 || ticks[i] <= ticks[quietest])) {
+            quietest = i;
+        }
+    }
+    return quietest;
+}
+
+} // namespace
+
+bool AudioSafeMode::priorityRestorable() {
+    if (geteuid() == 0) {
+        return true;
+    }
+    // Leaving SCHED_IDLE counts as raising the nice value back to the current one
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NICE, &limit) != 0) {
+        return false;
+    }
+    int nice = getpriority(PRIO_PROCESS, 0);
+    return limit.rlim_cur == RLIM_INFINITY || static_cast<rlim_t>(20 - nice) <= limit.rlim_cur;
+}
+
+void AudioSafeMode::enter(int cpu, uint32_t avoidPid) {
+    if (m_active) {
+        return;
+    }
+    m_active = true;
+
+    // Only the default time-sharing policies are lowered; a daemon started
+    // under chrt (or already idle) was set up that way on purpose. Idle
+    // priority is only used when leave() will be allowed to undo it.
+    int policy = sched_getscheduler(0);
+    int lowered = priorityRestorable() ? SCHED_IDLE : SCHED_BATCH;
+    if (!m_priorityLowered && (policy == SCHED_OTHER || policy == SCHED_BATCH) && policy != lowered) {
+        m_policy = policy;
+        bool changed = false;
+        forEachThread([lowered, &changed](pid_t tid) {
+            struct sched_param param = {};
+            changed = sched_setscheduler(tid, lowered, &param) == 0 || changed;
+        });
+        m_priorityLowered = changed;
+        m_idlePriority = changed && lowered == SCHED_IDLE;
+    }
+
+    if (sched_getaffinity(0, sizeof(m_affinity), &m_affinity) != 0 || CPU_COUNT(&m_affinity) < 2) {
+        return;
+    }
+    int target = cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &m_affinity) ? cpu : quietestCpu(m_affinity, avoidPid);
+    cpu_set_t pinned;
+    CPU_ZERO(&pinned);
+    CPU_SET(target, &pinned);
+    forEachThread([&pinned](pid_t tid) {
+        sched_setaffinity(tid, sizeof(pinned), &pinned);
+    });
+    m_pinnedCpu = target;
+}
+
+void AudioSafeMode::leave() {
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+
+    // Batch scheduling can always be left; idle only with RLIMIT_NICE headroom
+    if (m_priorityLowered && (!m_idlePriority || priorityRestorable())) {
+        bool restored = true;
+        forEachThread([this, &restored](pid_t tid) {
+            struct sched_param param = {};
+            restored = sched_setscheduler(tid, m_policy, &param) == 0 && restored;
+        });
+        m_priorityLowered = !restored;
+        m_idlePriority = m_idlePriority && !restored;
+    }
+    if (m_pinnedCpu >= 0) {
+        forEachThread([this](pid_t tid) {
+            sched_setaffinity(tid, sizeof(m_affinity), &m_affinity);
+        });
+        m_pinnedCpu = -1;
+    }
+}
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+/**
+ * @brief Keeps the whole process out of the audio engine's way while FL Studio records
+ *
+ * enter() drops every thread of the process to idle scheduling priority
+ * (SCHED_IDLE on Linux; idle priority class plus background mode on
+ * Windows, which also lowers I/O priority) and pins it to one CPU, so it
+ * neither preempts nor migrates across the cores the audio threads use.
+ * Threads started while active inherit both. leave() restores what was
+ * there before.
+ *
+ * On Linux the CPU is the allowed one FL Studio's threads have used least,
+ * counting each thread's CPU time on the CPU it last ran on; Windows
+ * doesn't say where a thread ran, so there it is the last allowed CPU.
+ *
+ * Linux only lets an unprivileged process leave SCHED_IDLE when
+ * RLIMIT_NICE allows its nice value (audio setups usually grant this to
+ * the audio group); priorityRestorable() says whether it does. Without
+ * that, enter() uses SCHED_BATCH instead: wakeups no longer preempt other
+ * threads, and switching back needs no privileges.
+ */
+class AudioSafeMode {
+    private:
+        bool m_active;
+        bool m_priorityLowered;
+        bool m_idlePriority;            // Lowered to idle rather than the batch fallback
+        int m_pinnedCpu;                // -1 if affinity was left alone
+#ifdef _WIN32
+        DWORD m_priorityClass;
+        DWORD_PTR m_affinity;
+#else
+        int m_policy;                   // Scheduling policy to restore
+        cpu_set_t m_affinity;
+#endif
+
+    public:
+        AudioSafeMode();
+        ~AudioSafeMode();
+
+        AudioSafeMode(const AudioSafeMode&) = delete;
+        AudioSafeMode& operator=(const AudioSafeMode&) = delete;
+
+        /**
+         * @brief Lower priority and pin the process
+         * @param cpu CPU to pin to, -1 to choose one
+         * @param avoidPid Process whose CPUs to stay off (FL Studio), 0 for none
+         */
+        void enter(int cpu, uint32_t avoidPid);
+
+        /**
+         * @brief Restore priority and affinity
+         */
+        void leave();
+
+        bool active() const { return m_active; }
+        bool priorityLowered() const { return m_priorityLowered; }
+        bool idlePriority() const { return m_idlePriority; }
+        int pinnedCpu() const { return m_pinnedCpu; }
+
+        /**
+         * @brief Whether leave() can undo the priority change without privileges
+         */
+        static bool priorityRestorable();
+};
@@ -0,0 +1,67 @@
+#include "clock.h"
+#include <thread>
+
+namespace {
+
+class SystemClock : public Clock {
+    public:
+        TimePoint now() const override {
+            return std::chrono::steady_clock::now();
+        }
+
+        long long unixTimeMs() const override {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        bool wait(WakeEvent& event, int timeoutMs) override {
+            return event.wait(timeoutMs);
+        }
+
+        void sleepFor(int ms) override {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }
+
+        bool realTime() const override {
+            return true;
+        }
+};
+
+} // namespace
+
+Clock& Clock::system() {
+    static SystemClock clock;
+    return clock;
+}
+
+SimulatedClock::SimulatedClock(long long startUnixMs)
+    : m_elapsedNs(0)
+    , m_startUnixMs(startUnixMs) {
+}
+
+Clock::TimePoint SimulatedClock::now() const {
+    return TimePoint(std::chrono::duration_cast<TimePoint::duration>(elapsed()));
+}
+
+long long SimulatedClock::unixTimeMs() const {
+    return m_startUnixMs + std::chrono::duration_cast<std::chrono::milliseconds>(elapsed()).count();
+}
+
+bool SimulatedClock::wait(WakeEvent& event, int timeoutMs) {
+    // A signal already pending ends the wait before any time passes
+    if (event.wait(0)) {
+        return true;
+    }
+    sleepFor(timeoutMs);
+    return false;
+}
+
+void SimulatedClock::sleepFor(int ms) {
+    if (ms > 0) {
+        advance(std::chrono::milliseconds(ms));
+    }
+}
+
+void SimulatedClock::advance(std::chrono::nanoseconds elapsed) {
+    m_elapsedNs.fetch_add(elapsed.count());
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "wake_event.h"
+
+/**
+ * @brief Source of time for everything that schedules
+ *
+ * Timeouts, back-off, debounce, liveness pings and presence timestamps read
+ * the time and wait through a Clock rather than std::chrono and
+ * sleep_for, so a SimulatedClock can replace the system one and replay
+ * hours of activity without waiting through them.
+ */
+class Clock {
+    public:
+        typedef std::chrono::steady_clock::time_point TimePoint;
+
+        virtual ~Clock() {}
+
+        /**
+         * @brief Monotonic time, for intervals and deadlines
+         */
+        virtual TimePoint now() const = 0;
+
+        /**
+         * @brief Wall clock in Unix milliseconds
+         * The script's write_time comes from another process (FL Studio, possibly
+         * under Wine), so only the wall clock can be compared with it.
+         */
+        virtual long long unixTimeMs() const = 0;
+
+        /**
+         * @brief Block until the event is signaled or timeoutMs passes
+         * @return true if signaled
+         */
+        virtual bool wait(WakeEvent& event, int timeoutMs) = 0;
+
+        /**
+         * @brief Block for ms milliseconds
+         */
+        virtual void sleepFor(int ms) = 0;
+
+        /**
+         * @brief Whether time passes by itself
+         * If not, no other thread can keep to it: work that would run on a
+         * background thread runs on the caller's instead.
+         */
+        virtual bool realTime() const = 0;
+
+        /**
+         * @brief Wall clock in Unix seconds, as Discord timestamps take it
+         */
+        long long unixTime() const { return unixTimeMs() / 1000; }
+
+        /**
+         * @brief The process-wide clock backed by std::chrono
+         */
+        static Clock& system();
+};
+
+/**
+ * @brief Clock that only moves when told to
+ *
+ * Waits return at once, having moved time forward by their timeout (or not
+ * at all when the event was already signaled), so a loop of update() and
+ * waitForNextTick() runs from one timer to the next with no real waiting.
+ * Reading the time is safe from any thread; moving it is meant for one.
+ */
+class SimulatedClock : public Clock {
+    private:
+        std::atomic<int64_t> m_elapsedNs;
+        long long m_startUnixMs;
+
+    public:
+        /**
+         * @param startUnixMs Wall clock at the start of the simulation
+         */
+        explicit SimulatedClock(long long startUnixMs);
+
+        TimePoint now() const override;
+        long long unixTimeMs() const override;
+        bool wait(WakeEvent& event, int timeoutMs) override;
+        void sleepFor(int ms) override;
+        bool realTime() const override { return false; }
+
+        /**
+         * @brief Move time forward
+         */
+        void advance(std::chrono::nanoseconds elapsed);
+
+        /**
+         * @brief Simulated time since construction
+         */
+        std::chrono::nanoseconds elapsed() const { return std::chrono::nanoseconds(m_elapsedNs.load()); }
+};
@@ -0,0 +1,86 @@
+#include "coalescer.h"
+
+PresenceCoalescer::PresenceCoalescer(const CoalescePolicy& policy)
+    : m_policy(policy)
+    , m_changedAt()
+    , m_hasObservation(false)
+    , m_changesSinceSend(0)
+    , m_merged(0)
+    , m_sent(0) {
+}
+
+int PresenceCoalescer::settleMs(Field field) const {
+    switch (field) {
+        case STATE:   return m_policy.stateMs;
+        case BPM:     return m_policy.bpmMs;
+        case PLUGIN:  return m_policy.pluginMs;
+        case PROJECT: return m_policy.projectMs;
+        case USAGE:   return 0;  // Only changes once per sample interval anyway
+        default:      return 0;  // A new session's start time goes out at once
+    }
+}
+
+bool PresenceCoalescer::shouldSend(const DiscordActivity& observed, const DiscordActivity& shown, Clock::TimePoint now) {
+    // Restart the settle timer of every field whose observed value moved
+    bool changed[FIELD_COUNT] = {
+        observed.state != m_observed.state,
+        observed.bpm != m_observed.bpm,
+        observed.plugin != m_observed.plugin,
+        observed.projectName != m_observed.projectName,
+        observed.startTime != m_observed.startTime || observed.endTime != m_observed.endTime,
+        observed.cpuPercent != m_observed.cpuPercent || observed.memoryMb != m_observed.memoryMb
+    };
+    bool anyChanged = false;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        if (changed[f] || !m_hasObservation) {
+            m_changedAt[f] = now;
+            anyChanged = anyChanged || changed[f];
+        }
+    }
+    if (anyChanged && m_hasObservation) {
+        m_changesSinceSend++;
+    }
+    m_observed = observed;
+    m_hasObservation = true;
+
+    if (observed == shown) {
+        // Everything seen since the last send came back to what Discord shows
+        m_merged += m_changesSinceSend;
+        m_changesSinceSend = 0;
+        return false;
+    }
+
+    // Send once every differing field has settled, or as soon as one with no
+    // settle time differs
+    bool differs[FIELD_COUNT] = {
+        observed.state != shown.state,
+        observed.bpm != shown.bpm,
+        observed.plugin != shown.plugin,
+        observed.projectName != shown.projectName,
+        observed.startTime != shown.startTime || observed.endTime != shown.endTime,
+        observed.cpuPercent != shown.cpuPercent || observed.memoryMb != shown.memoryMb
+    };
+    bool allSettled = true;
+    for (int f = 0; f < FIELD_COUNT; f++) {
+        if (!differs[f]) {
+            continue;
+        }
+        int settle = settleMs(static_cast<Field>(f));
+        if (settle <= 0) {
+            return true;
+        }
+        if (now - m_changedAt[f] < std::chrono::milliseconds(settle)) {
+            allSettled = false;
+        }
+    }
+    return allSettled;
+}
+
+void PresenceCoalescer::markSent() {
+    // Only the newest of the changes since the last send reached Discord
+    if (m_changesSinceSend > 1) {
+        m_merged += m_changesSinceSend - 1;
+    }
+    m_changesSinceSend = 0;
+    m_sent++;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "clock.h"
+#include "discord_rp.h"
+
+/**
+ * @brief How long each presence field must hold still before it is sent
+ *
+ * 0 sends a change on the tick it is seen. Any immediate change also carries
+ * the latest values of the settling fields with it.
+ */
+struct CoalescePolicy {
+    int stateMs;        // Recording/Listening/... transitions
+    int bpmMs;          // Tempo automation and jitter
+    int pluginMs;       // Focus flips while browsing plugins
+    int projectMs;
+    
+    CoalescePolicy() : stateMs(0), bpmMs(1500), pluginMs(2000), projectMs(0) {}
+};
+
+/**
+ * @brief Debounce stage between the parsed FL Studio state and Discord
+ *
+ * Fed the observed activity every tick, decides whether it differs enough
+ * from what Discord shows, for long enough, to be worth a frame. Changes that
+ * are superseded or reverted before they are sent are counted as merged.
+ */
+class PresenceCoalescer {
+    private:
+        enum Field { STATE, BPM, PLUGIN, PROJECT, START_TIME, USAGE, FIELD_COUNT };
+
+        CoalescePolicy m_policy;
+        DiscordActivity m_observed;             // Latest observation
+        Clock::TimePoint m_changedAt[FIELD_COUNT];
+        bool m_hasObservation;
+        uint64_t m_changesSinceSend;            // Observations that differed from the previous one
+        uint64_t m_merged;
+        uint64_t m_sent;
+
+        int settleMs(Field field) const;
+
+    public:
+        explicit PresenceCoalescer(const CoalescePolicy& policy = CoalescePolicy());
+
+        void setPolicy(const CoalescePolicy& policy) { m_policy = policy; }
+
+        /**
+         * @brief Record this tick's observation and decide whether to send it
+         * @param observed Activity built from the state file
+         * @param shown Activity Discord is known to show
+         * @return true if observed should be sent now
+         */
+        bool shouldSend(const DiscordActivity& observed, const DiscordActivity& shown, Clock::TimePoint now);
+
+        /**
+         * @brief Count a send decided by shouldSend() as done
+         */
+        void markSent();
+
+        uint64_t mergedUpdates() const { return m_merged; }
+        uint64_t sentUpdates() const { return m_sent; }
+};
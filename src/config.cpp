@@ -1,9 +1,16 @@
 #include "config.h"
+#include "logger.h"
 #include <algorithm>
 #include <iostream>
 #include <vector>
 #include <fstream>
+#include <filesystem>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#include <climits>
+#endif
 
 ConfigLoader::ConfigLoader() {
     
@@ -36,11 +43,21 @@ std::string ConfigLoader::findEnvFile(const std::string& filename) const {
     searchPaths.push_back(std::filesystem::current_path() / filename);
     
     // 2. Executable directory (most important for Start Menu launches)
+#ifdef _WIN32
     char exePath[MAX_PATH];
     if (GetModuleFileNameA(nullptr, exePath, MAX_PATH) != 0) {
         std::filesystem::path executableDir = std::filesystem::path(exePath).parent_path();
         searchPaths.push_back(executableDir / filename);
     }
+#else
+    char exePath[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+    if (length > 0) {
+        exePath[length] = '\0';
+        std::filesystem::path executableDir = std::filesystem::path(exePath).parent_path();
+        searchPaths.push_back(executableDir / filename);
+    }
+#endif
     
     // 3. Project root directory
     std::string projectRoot = findProjectRoot();
@@ -48,21 +65,15 @@ std::string ConfigLoader::findEnvFile(const std::string& filename) const {
     
     // Try each location
     for (const auto& path : searchPaths) {
-        if (debugMode) {
-            std::cout << "Searching for .env at: " << path.string() << std::endl;
-        }
+        LOG_DEBUG("Searching for .env at: {}", path.string());
         if (std::filesystem::exists(path)) {
-            if (debugMode) {
-                std::cout << "Found .env at: " << path.string() << std::endl;
-            }
+            LOG_DEBUG("Found .env at: {}", path.string());
             return path.string();
         }
     }
     
     // Not found anywhere
-    if (debugMode) {
-        std::cout << "Environment file '" << filename << "' not found in any search location." << std::endl;
-    }
+    LOG_DEBUG("Environment file '{}' not found in any search location.", filename);
     return "";
 }
 
@@ -80,9 +91,7 @@ bool ConfigLoader::loadEnvFile(const std::string& filename) {
         return false;
     }
 
-    if (debugMode) {
-        std::cout << "Loading environment variables from: " << actualPath << std::endl;
-    }
+    LOG_DEBUG("Loading environment variables from: {}", actualPath);
 
     std::string line;
     while (std::getline(file, line)) {
@@ -102,7 +111,7 @@ bool ConfigLoader::loadEnvFile(const std::string& filename) {
             value.erase(value.find_last_not_of(" \t") + 1);
 
             if (value.size() >= 2 &&
-                ((value.front() == '""' && value.back() == '""') ||
+                ((value.front() == '"' && value.back() == '"') ||
                 (value.front() == '\'' && value.back() == '\''))) {
                 value = value.substr(1, value.size() - 2);
             }
@@ -115,16 +124,18 @@ bool ConfigLoader::loadEnvFile(const std::string& filename) {
 }
 
 std::string ConfigLoader::getString(const std::string& key, const std::string& defaultValue) const {
-    if ( config.contains(key)) {
-        return config[key].get<std::string>();
+    auto it = config.find(key);
+    if (it != config.end()) {
+        return it->second;
     }
     return defaultValue;
 }
 
 int ConfigLoader::getInt(const std::string& key, int defaultValue) const {
-    if (config.contains(key)) {
+    auto it = config.find(key);
+    if (it != config.end()) {
         try {
-            return std::stoi(config[key].get<std::string>());
+            return std::stoi(it->second);
         } catch (const std::exception&) {
             return defaultValue;
         }
@@ -133,8 +144,9 @@ int ConfigLoader::getInt(const std::string& key, int defaultValue) const {
 }
 
 bool ConfigLoader::getBool(const std::string& key, bool defaultValue) const {
-    if (config.contains(key)) {
-        std::string value = config[key].get<std::string>();
+    auto it = config.find(key);
+    if (it != config.end()) {
+        std::string value = it->second;
         std::transform(value.begin(), value.end(), value.begin(), ::tolower);
         return value == "true" || value == "1" || value == "yes";
     }
@@ -147,7 +159,17 @@ void ConfigLoader::setDebugMode(bool debug) {
 
 void ConfigLoader::printAll() const {
     if (debugMode) {
-        std::cout << "Configuration:" << std::endl;
-        std::cout << config.dump(2) << std::endl;
+        std::vector<const std::pair<const std::string, std::string>*> entries;
+        for (const auto& entry : config) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](const auto* a, const auto* b) {
+            return a->first < b->first;
+        });
+
+        LOG_DEBUG("Configuration:");
+        for (const auto* entry : entries) {
+            LOG_DEBUG("  {}={}", entry->first, entry->second);
+        }
     }
 }
\ No newline at end of file
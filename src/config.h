@@ -1,9 +1,10 @@
-#include <filesystem>
-#include "../lib/json.hpp"
+#pragma once
+#include <string>
+#include <unordered_map>
 
 class ConfigLoader {
     private:
-        nlohmann::json config;
+        std::unordered_map<std::string, std::string> config;
         bool debugMode = false;
         std::string findProjectRoot() const;
         std::string findEnvFile(const std::string& filename) const;
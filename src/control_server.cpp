@@ -0,0 +1,299 @@
+#include "control_server.h"
+#include "app_state.h"
+#include "json_lite.h"
+#include "presence.h"
+#include "trace.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static std::string_view stateName(AppState::State state) {
+    switch (state) {
+        case AppState::State::STOPPED:      return "stopped";
+        case AppState::State::MONITORING:   return "monitoring";
+        case AppState::State::DISCONNECTED: return "disconnected";
+    }
+    return "unknown";
+}
+
+static void appendBool(ArenaWriter& out, std::string_view key, bool value) {
+    out += ",\"";
+    out += key;
+    out += value ? "\":true" : "\":false";
+}
+
+static void appendNumber(ArenaWriter& out, std::string_view key, long long value) {
+    out += ",\"";
+    out += key;
+    out += "\":";
+    out.appendInt(value);
+}
+
+static void appendLatency(ArenaWriter& out, std::string_view key, const LatencySummary& latency) {
+    out += ",\"";
+    out += key;
+    out += "\":{\"n\":";
+    out.appendInt(static_cast<long long>(latency.count));
+    appendNumber(out, "p50_us", static_cast<long long>(latency.p50Micros));
+    appendNumber(out, "p99_us", static_cast<long long>(latency.p99Micros));
+    appendNumber(out, "max_us", static_cast<long long>(latency.maxMicros));
+    out += '}';
+}
+
+static void appendString(ArenaWriter& out, std::string_view key, std::string_view value) {
+    out += ",\"";
+    out += key;
+    out += "\":\"";
+    appendJsonEscaped(out, value);
+    out += '"';
+}
+
+ControlServer::ControlServer(AppState& app)
+    : m_app(app)
+    , m_listen(-1)
+    , m_stopRequested(false)
+    , m_arena(4 * 1024) {
+    m_wake[0] = -1;
+    m_wake[1] = -1;
+}
+
+ControlServer::~ControlServer() {
+    stop();
+}
+
+void ControlServer::handle(std::string_view command, ArenaWriter& reply) {
+    if (command == "status") {
+        AppState::Status status = m_app.getStatus();
+        reply += "{\"ok\":true";
+        appendString(reply, "state", stateName(status.state));
+        appendBool(reply, "fl_studio", status.flStudioRunning);
+        appendBool(reply, "discord", status.discordConnected);
+        appendBool(reply, "paused", status.paused);
+        appendBool(reply, "audio_safe", status.audioSafe);
+        appendString(reply, "poll_mode", pollModeName(status.pollMode));
+        appendNumber(reply, "session_start", status.sessionStartTime);
+        appendNumber(reply, "last_update", status.lastUpdateTime);
+        reply += ",\"activity\":{\"state\":\"";
+        reply += presenceStateName(status.activity.state);
+        reply += '"';
+        appendNumber(reply, "bpm", status.activity.bpm);
+        appendString(reply, "plugin", status.activity.plugin.view());
+        appendString(reply, "project", status.activity.projectName.view());
+        reply += "}}";
+        return;
+    }
+    if (command == "metrics") {
+        AppState::Status status = m_app.getStatus();
+        reply += "{\"ok\":true";
+        appendNumber(reply, "updates_sent", static_cast<long long>(status.updatesSent));
+        appendNumber(reply, "updates_merged", static_cast<long long>(status.updatesMerged));
+        appendNumber(reply, "updates_dropped", static_cast<long long>(status.updatesDropped));
+        appendNumber(reply, "requests_timed_out", static_cast<long long>(status.requestsTimedOut));
+        if (status.flStudioUsage.cpuPercent >= 0) {
+            appendNumber(reply, "fl_cpu_percent", status.flStudioUsage.cpuPercent);
+        }
+        if (status.flStudioUsage.rssBytes > 0) {
+            appendNumber(reply, "fl_rss_bytes", static_cast<long long>(status.flStudioUsage.rssBytes));
+        }
+        appendLatency(reply, "script_to_parse", status.scriptToParse);
+        appendLatency(reply, "parse_to_ack", status.parseToAck);
+        appendLatency(reply, "script_to_ack", status.scriptToAck);
+        reply += ",\"wakeups_per_hour\":{\"";
+        for (size_t i = 0; i < WakeupStats::MODES; i++) {
+            PollMode mode = static_cast<PollMode>(i);
+            if (i > 0) {
+                reply += ",\"";
+            }
+            reply += pollModeName(mode);
+            reply += "\":";
+            reply.appendInt(static_cast<long long>(status.wakeups.perHour(mode)));
+        }
+        reply += '}';
+        reply += '}';
+        return;
+    }
+    if (command == "trace start") {
+        Tracer::start();
+        reply += "{\"ok\":true";
+        appendString(reply, "file", Tracer::outputPath());
+        reply += '}';
+        return;
+    }
+    if (command == "trace stop") {
+        // Writes the file on this thread, never the update loop's
+        size_t events = 0;
+        if (!Tracer::stop(events)) {
+            reply += "{\"ok\":false,\"error\":\"not tracing or write failed\"}";
+            return;
+        }
+        reply += "{\"ok\":true";
+        appendNumber(reply, "events", static_cast<long long>(events));
+        appendString(reply, "file", Tracer::outputPath());
+        reply += '}';
+        return;
+    }
+
+    if (command == "refresh") {
+        m_app.requestRefresh();
+    } else if (command == "disconnect") {
+        m_app.requestDisconnect();
+    } else if (command == "pause") {
+        m_app.requestPause();
+    } else if (command == "resume") {
+        m_app.requestResume();
+    } else if (command == "exit") {
+        m_app.requestExit();
+    } else {
+        reply += "{\"ok\":false,\"error\":\"unknown command\"}";
+        return;
+    }
+    reply += "{\"ok\":true}";
+}
+
+bool ControlServer::start(const std::string& path) {
+    if (m_thread.joinable()) {
+        return true;
+    }
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    m_listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listen == -1) {
+        return false;
+    }
+
+    // Commands can quit the app: the socket is created owner-only, so there
+    // is no window between bind() and a chmod() in which others can connect
+    mode_t previousMask = umask(S_IRWXG | S_IRWXO);
+    bool bound = bind(m_listen, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == 0;
+    if (!bound && errno == EADDRINUSE) {
+        // Left behind by an instance that didn't exit cleanly, unless something still answers on it
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe != -1 && ::connect(probe, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == 0;
+        if (probe != -1) {
+            close(probe);
+        }
+        if (!live) {
+            unlink(path.c_str());
+            bound = bind(m_listen, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == 0;
+        }
+    }
+    umask(previousMask);
+
+    if (!bound || listen(m_listen, 4) == -1 ||
+        pipe2(m_wake, O_NONBLOCK | O_CLOEXEC) == -1) {
+        close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+
+    m_path = path;
+    m_stopRequested.store(false);
+    m_thread = std::thread(&ControlServer::run, this);
+    return true;
+}
+
+void ControlServer::stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    m_stopRequested.store(true);
+    char byte = 0;
+    (void)!write(m_wake[1], &byte, 1);
+    m_thread.join();
+
+    close(m_listen);
+    close(m_wake[0]);
+    close(m_wake[1]);
+    m_listen = -1;
+    m_wake[0] = -1;
+    m_wake[1] = -1;
+    unlink(m_path.c_str());
+}
+
+void ControlServer::run() {
+    while (!m_stopRequested.load()) {
+        struct pollfd fds[2];
+        fds[0].fd = m_listen;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = m_wake[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        if (::poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN)) {
+            continue;
+        }
+
+        int client = accept4(m_listen, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client == -1) {
+            continue;
+        }
+        serve(client);
+        close(client);
+    }
+}
+
+// One client at a time: requests are tiny and answered from the snapshot
+void ControlServer::serve(int client) {
+    struct timeval timeout;
+    timeout.tv_sec = CLIENT_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (CLIENT_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char line[MAX_LINE];
+    size_t used = 0;
+    for (;;) {
+        ssize_t n = recv(client, line + used, sizeof(line) - used, 0);
+        if (n == 0 && used > 0 && used < sizeof(line)) {
+            // Last command without a trailing newline (e.g. printf status | nc -U)
+            line[used++] = '\n';
+        } else if (n <= 0) {
+            return;
+        } else {
+            used += static_cast<size_t>(n);
+        }
+
+        size_t start = 0;
+        for (size_t i = 0; i < used; i++) {
+            if (line[i] != '\n') {
+                continue;
+            }
+            std::string_view command(line + start, i - start);
+            if (!command.empty() && command.back() == '\r') {
+                command.remove_suffix(1);
+            }
+            start = i + 1;
+            if (command.empty()) {
+                continue;
+            }
+
+            ArenaWriter reply(m_arena);
+            handle(command, reply);
+            reply += '\n';
+            if (send(client, reply.data(), reply.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(reply.size())) {
+                return;
+            }
+            m_arena.reset();
+        }
+
+        // Keep the unfinished line; one that fills the buffer can't be a command
+        if (start == 0 && used == sizeof(line)) {
+            return;
+        }
+        std::memmove(line, line + start, used - start);
+        used -= start;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "arena.h"
+
+class AppState;
+
+/**
+ * @brief Local control socket for scripts, dashboards and headless runs
+ *
+ * Clients send one command per line and get one line of compact JSON back:
+ *
+ *   status      state, FL Studio, Discord, pause flag, session and last activity
+ *   metrics     update counters, state file staleness, wakeups per hour by poll mode
+ *   refresh     reconnect to Discord (tray: Refresh Connection)
+ *   disconnect  stop monitoring and disconnect (tray: Disconnect)
+ *   pause       clear the presence and stop updating it
+ *   resume      show the presence again
+ *   exit        quit the application (tray: Exit)
+ *   trace start start recording spans (see Tracer)
+ *   trace stop  stop recording and write the Chrome trace file
+ *
+ * Every reply has "ok"; failures add "error". Commands are posted to
+ * AppState with the same request methods the tray uses and take effect on
+ * the next update; status is read from the published snapshot. The server
+ * runs on its own thread and never blocks the update loop.
+ *
+ * Linux only (AF_UNIX); it isn't built on Windows, where the tray is the
+ * control surface.
+ */
+class ControlServer {
+    private:
+        static const size_t MAX_LINE = 256;
+        // Clients that stop sending are dropped after this long
+        static const int CLIENT_TIMEOUT_MS = 1000;
+
+        AppState& m_app;
+        std::string m_path;
+        int m_listen;                   // -1 while not started
+        int m_wake[2];                  // Pipe that interrupts the server thread's poll() on stop
+        std::thread m_thread;
+        std::atomic<bool> m_stopRequested;
+        TickArena m_arena;              // Server thread's scratch memory for replies
+
+        void run();
+        void serve(int client);
+        void handle(std::string_view command, ArenaWriter& reply);
+
+    public:
+        explicit ControlServer(AppState& app);
+        ~ControlServer();
+
+        ControlServer(const ControlServer&) = delete;
+        ControlServer& operator=(const ControlServer&) = delete;
+
+        /**
+         * @brief Listen on path and start serving clients
+         * A stale socket file left by a crashed instance is replaced; one a
+         * running instance still answers on is not.
+         * @return true if listening
+         */
+        bool start(const std::string& path);
+
+        /**
+         * @brief Stop serving and remove the socket file
+         */
+        void stop();
+
+        bool isRunning() const { return m_thread.joinable(); }
+};
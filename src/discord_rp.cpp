@@ -1,19 +1,66 @@
 #include "discord_rp.h"
-#include <iostream>
-#include <sstream>
+#include "json_lite.h"
+#include "trace.h"
+#include <charconv>
 #include <chrono>
-#include <vector>
+#include <cerrno>
+#include <cstring>
 
 #ifdef _WIN32
 #include <io.h>
 #else
+#include <poll.h>
 #include <unistd.h>
-#include <cstring>
 #endif
 
-DiscordRPC::DiscordRPC(const std::string& clientId) : clientId(clientId), connected(false) {
+// A link with no incoming traffic for this long is pinged; if the ping isn't
+// answered within DiscordTimeouts::pingMs the link is considered dead (half-open)
+static const int IDLE_PING_MS = 15000;
+
+// Deadlines for I/O that blocks within one call (a write, the handshake, a
+// waited-for response) are real time whatever the injected Clock says: the
+// bytes move in real time. Timeouts that span ticks follow the Clock.
+typedef std::chrono::steady_clock IoClock;
+
+// Whole milliseconds left until the deadline, 0 once it has passed
+static int millisecondsUntil(IoClock::time_point deadline) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - IoClock::now()).count();
+    return remaining > 0 ? static_cast<int>(remaining) : 0;
+}
+
+static uint64_t microsecondsBetween(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+// Discord IPC opcodes
+static const uint32_t OP_HANDSHAKE = 0;
+static const uint32_t OP_FRAME = 1;
+static const uint32_t OP_CLOSE = 2;
+static const uint32_t OP_PING = 3;
+static const uint32_t OP_PONG = 4;
+
+DiscordRPC::DiscordRPC(const std::string& clientId, const DiscordTimeouts& timeouts,
+                       const PresenceFormat& format, Clock& clock)
+    : connected(false)
+    , clientId(clientId)
+    , timeouts(timeouts)
+    , format(format)
+    , clock(clock)
+    , pingOutstanding(false)
+    , timedOutRequests(0)
+    , nextNonce(1)
+    , pending()
+    , pendingCount(0)
+    , completedHead(0)
+    , completedCount(0)
+    , hasQueued(false)
+    , queuedPriority(PresencePriority::Detail)
+    , droppedUpdates(0)
+    , receiveStart(0)
+    , receiveEnd(0) {
 #ifdef _WIN32
     pipe = INVALID_HANDLE_VALUE;
+    ioEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
 #else
     sock = -1;
 #endif
@@ -21,220 +68,488 @@ DiscordRPC::DiscordRPC(const std::string& clientId) : clientId(clientId), connec
 
 DiscordRPC::~DiscordRPC() {
     disconnect();
+#ifdef _WIN32
+    if (ioEvent) {
+        CloseHandle(ioEvent);
+    }
+#endif
 }
 
-std::string DiscordRPC::createHandshakeMessage() {
-    std::string handshake = R"({"v":1,"client_id":")" + clientId + R"("})";
-    return handshake;
+// Starts a frame with room for the opcode/length header
+static void beginFrame(ArenaWriter& frame) {
+    frame += std::string_view("\0\0\0\0\0\0\0\0", 8);
 }
 
-std::string DiscordRPC::createActivityMessage(const DiscordActivity& activity) {
-    auto now = getCurrentTimestamp();
-    
-    std::stringstream ss;
-    ss << R"({
-        "cmd": "SET_ACTIVITY",
-        "nonce": ")" << now << R"(",
-        "args": {
-            "pid": )" << 
+// Fills in the header once the payload length is known
+static std::string_view finishFrame(ArenaWriter& frame, uint32_t opcode) {
+    uint32_t length = static_cast<uint32_t>(frame.size() - 8);
+    std::memcpy(frame.data(), &opcode, sizeof(opcode));
+    std::memcpy(frame.data() + 4, &length, sizeof(length));
+    return frame.view();
+}
+
+std::string_view DiscordRPC::createHandshakeMessage(TickArena& arena) {
+    ArenaWriter frame(arena);
+    beginFrame(frame);
+    frame += std::string_view(R"({"v":1,"client_id":)");
+    appendJsonString(frame, clientId);
+    frame += '}';
+    return finishFrame(frame, OP_HANDSHAKE);
+}
+
+static void appendCommandHeader(ArenaWriter& out, uint64_t nonce) {
+    out += std::string_view(R"({"cmd":"SET_ACTIVITY","nonce":")");
+    out.appendInt(static_cast<long long>(nonce));
+    out += std::string_view(R"(","args":{"pid":)");
 #ifdef _WIN32
-    GetCurrentProcessId() 
+    out.appendInt(GetCurrentProcessId());
 #else
-    getpid()
+    out.appendInt(getpid());
 #endif
-    << R"(,
-            "activity": {)";
-    
-    if (!activity.state.empty()) {
-        ss << R"("state": ")" << activity.state << R"(",)";
+}
+
+// Appends ,"key":"text" from a template. Discord rejects text shorter than
+// two characters, so a field that renders less is left out
+static void appendTemplateField(ArenaWriter& out, std::string_view key, const PresenceTemplate& text,
+                                const PresenceFields& fields) {
+    size_t start = out.size();
+    out += key;
+    if (text.render(fields, out) < 2) {
+        out.truncate(start);
+        return;
     }
+    out += '"';
+}
+
+std::string_view DiscordRPC::createActivityMessage(const DiscordActivity& activity, uint64_t nonce, TickArena& arena) {
+    ArenaWriter result(arena, 512);
+    beginFrame(result);
+
+    appendCommandHeader(result, nonce);
+    
+    // Interned asset keys first, so every text field after them starts with a comma
+    result += std::string_view(R"(,"activity":{"assets":{"large_image":")");
+    result += presence_text::LARGE_IMAGE;
+    result += std::string_view(R"(","large_text":")");
+    result += presence_text::LARGE_TEXT;
+    result += std::string_view(R"(","small_image":")");
+    result += presenceStateAsset(activity.state);
+    result += std::string_view("\"}");
     
-    if (!activity.details.empty()) {
-        ss << R"("details": ")" << activity.details << R"(",)";
+    if (activity.state == PresenceState::Starting) {
+        result += std::string_view(R"(,"state":")");
+        result += presence_text::STARTING_STATE;
+        result += std::string_view(R"(","details":")");
+        result += presence_text::STARTING_DETAILS;
+        result += '"';
+    } else {
+        PresenceFields fields = { activity.state, activity.bpm, activity.plugin.view(), activity.projectName.view(),
+                                  activity.cpuPercent, activity.memoryMb };
+        appendTemplateField(result, R"(,"state":")", format.state, fields);
+        appendTemplateField(result, R"(,"details":")", format.details, fields);
     }
     
     // Add timestamps if provided
     if (activity.startTime > 0 || activity.endTime > 0) {
-        ss << R"("timestamps": {)";
+        result += std::string_view(R"(,"timestamps":{)");
         if (activity.startTime > 0) {
-            ss << R"("start": )" << activity.startTime;
-            if (activity.endTime > 0) ss << ",";
+            result += std::string_view(R"("start":)");
+            result.appendInt(activity.startTime);
+            if (activity.endTime > 0) result += ',';
         }
         if (activity.endTime > 0) {
-            ss << R"("end": )" << activity.endTime;
+            result += std::string_view(R"("end":)");
+            result.appendInt(activity.endTime);
         }
-        ss << "},";
+        result += '}';
     }
+    result += std::string_view("}}}");
     
-    // Add assets if provided
-    if (!activity.largeImage.empty() || !activity.smallImage.empty()) {
-        ss << R"("assets": {)";
-        if (!activity.largeImage.empty()) {
-            ss << R"("large_image": ")" << activity.largeImage << R"(")";
-            if (!activity.largeText.empty()) {
-                ss << R"(, "large_text": ")" << activity.largeText << R"(")";
-            }
-            if (!activity.smallImage.empty()) ss << ",";
+    return finishFrame(result, OP_FRAME);
+}
+
+std::string_view DiscordRPC::createClearActivityMessage(uint64_t nonce, TickArena& arena) {
+    ArenaWriter result(arena, 128);
+    beginFrame(result);
+    appendCommandHeader(result, nonce);
+    result += std::string_view(R"(,"activity":null}})");
+    return finishFrame(result, OP_FRAME);
+}
+
+bool DiscordRPC::writeMessage(std::string_view frame) {
+    TraceScope trace(Tracer::Span::IpcWrite);
+    // A frame cut short would desync the stream, so a write that misses its
+    // deadline takes the connection down with it
+#ifdef _WIN32
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = ioEvent;
+    DWORD written = 0;
+    if (!WriteFile(pipe, frame.data(), static_cast<DWORD>(frame.size()), nullptr, &overlapped)) {
+        if (GetLastError() != ERROR_IO_PENDING) {
+            dropConnection("write failed");
+            return false;
         }
-        if (!activity.smallImage.empty()) {
-            ss << R"("small_image": ")" << activity.smallImage << R"(")";
-            if (!activity.smallText.empty()) {
-                ss << R"(, "small_text": ")" << activity.smallText << R"(")";
-            }
+        if (WaitForSingleObject(ioEvent, static_cast<DWORD>(timeouts.ioMs)) != WAIT_OBJECT_0) {
+            // The OVERLAPPED must outlive the operation: cancel and wait for it
+            CancelIoEx(pipe, &overlapped);
+            GetOverlappedResult(pipe, &overlapped, &written, TRUE);
+            dropConnection("write timed out");
+            return false;
         }
-        ss << "},";
     }
-    
-    // Remove trailing comma if exists
-    std::string result = ss.str();
-    if (result.back() == ',') {
-        result.pop_back();
+    if (!GetOverlappedResult(pipe, &overlapped, &written, FALSE) || written != frame.size()) {
+        dropConnection("write failed");
+        return false;
     }
-    
-    result += R"(
+    return true;
+#else
+    // MSG_NOSIGNAL: a dead peer must surface as EPIPE, not kill the process with SIGPIPE
+    auto deadline = IoClock::now() + std::chrono::milliseconds(timeouts.ioMs);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = send(sock, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Socket buffer full: Discord isn't reading
+            struct pollfd pfd;
+            pfd.fd = sock;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            int remaining = millisecondsUntil(deadline);
+            if (remaining > 0 && ::poll(&pfd, 1, remaining) > 0) {
+                continue;  // Writable, or an error the next send reports
             }
+            dropConnection("write timed out");
+            return false;
         }
-    })";
-    
-    return result;
+        dropConnection(errno == EPIPE ? "closed by Discord" : "write failed");
+        return false;
+    }
+    return true;
+#endif
 }
 
-std::string DiscordRPC::createClearActivityMessage() {
-    auto now = getCurrentTimestamp();
-    
-    std::stringstream ss;
-    ss << R"({
-        "cmd": "SET_ACTIVITY",
-        "nonce": ")" << now << R"(",
-        "args": {
-            "pid": )" << 
-#ifdef _WIN32
-    GetCurrentProcessId() 
-#else
-    getpid()
-#endif
-    << R"(,
-            "activity": null
+void DiscordRPC::dropConnection(std::string_view reason) {
+    if (connected) {
+        disconnect();
+        disconnectReason = reason;
+    }
+}
+
+// Top-level fields of an incoming frame that matter for routing
+struct FrameFields {
+    std::string_view cmd;
+    std::string_view evt;
+    std::string_view nonce;
+    std::string_view data;   // Raw JSON of the "data" member
+};
+
+static bool parseFrameFields(std::string_view body, TickArena& arena, FrameFields& fields) {
+    FlatJsonReader reader(body.data(), body.size());
+    std::string_view key;
+    while (reader.nextKey(key)) {
+        if (key == "cmd") {
+            reader.readString(arena, fields.cmd);
+        } else if (key == "evt") {
+            reader.readString(arena, fields.evt);   // null for command responses
+        } else if (key == "nonce") {
+            reader.readString(arena, fields.nonce); // null for DISPATCH events
+        } else if (key == "data") {
+            reader.readRaw(fields.data);
+        } else {
+            reader.skipValue();
         }
-    })";
-    
-    return ss.str();
+    }
+    return !reader.failed();
 }
 
-void DiscordRPC::writeMessage(const std::string& message, int opcode) {
-    uint32_t length = static_cast<uint32_t>(message.length());
-    uint32_t op = static_cast<uint32_t>(opcode);
-    
+bool DiscordRPC::waitReadable(int timeoutMs) {
 #ifdef _WIN32
-    DWORD written;
-    WriteFile(pipe, &op, sizeof(op), &written, nullptr);
-    WriteFile(pipe, &length, sizeof(length), &written, nullptr);
-    WriteFile(pipe, message.c_str(), length, &written, nullptr);
+    auto deadline = IoClock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        DWORD available = 0;
+        if (!PeekNamedPipe(pipe, nullptr, 0, nullptr, &available, nullptr)) {
+            return true;  // Broken pipe - let the read report it
+        }
+        if (available > 0) {
+            return true;
+        }
+        if (IoClock::now() >= deadline) {
+            return false;
+        }
+        Sleep(1);
+    }
 #else
-    write(sock, &op, sizeof(op));
-    write(sock, &length, sizeof(length));
-    write(sock, message.c_str(), length);
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return ::poll(&pfd, 1, timeoutMs) > 0;
 #endif
 }
 
-std::string DiscordRPC::readMessage() {
-    uint32_t opcode, length;
+bool DiscordRPC::fillReceiveBuffer() {
+    // Compact so there is room at the end
+    if (receiveStart > 0) {
+        std::memmove(receiveBuffer, receiveBuffer + receiveStart, receiveEnd - receiveStart);
+        receiveEnd -= receiveStart;
+        receiveStart = 0;
+    }
+    size_t space = RECEIVE_BUFFER_SIZE - receiveEnd;
+    if (space == 0) {
+        return true;
+    }
     
 #ifdef _WIN32
-    DWORD read;
-    if (!ReadFile(pipe, &opcode, sizeof(opcode), &read, nullptr) || read != sizeof(opcode)) {
-        return "";
+    DWORD available = 0;
+    if (!PeekNamedPipe(pipe, nullptr, 0, nullptr, &available, nullptr)) {
+        dropConnection("closed by Discord");  // ERROR_BROKEN_PIPE
+        return false;
     }
-    if (!ReadFile(pipe, &length, sizeof(length), &read, nullptr) || read != sizeof(length)) {
-        return "";
+    if (available == 0) {
+        return true;
     }
-    
-    if (length > 0 && length < 65536) { // Sanity check
-        std::vector<char> buffer(length + 1);
-        if (ReadFile(pipe, buffer.data(), length, &read, nullptr) && read == length) {
-            buffer[length] = '\0';
-            return std::string(buffer.data());
+    // The bytes are already in the pipe, so this completes at once unless
+    // something is badly wrong; it is still bounded by the I/O budget
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = ioEvent;
+    DWORD read = 0;
+    DWORD toRead = available < space ? available : static_cast<DWORD>(space);
+    if (!ReadFile(pipe, receiveBuffer + receiveEnd, toRead, nullptr, &overlapped)) {
+        if (GetLastError() != ERROR_IO_PENDING) {
+            dropConnection("read failed");
+            return false;
+        }
+        if (WaitForSingleObject(ioEvent, static_cast<DWORD>(timeouts.ioMs)) != WAIT_OBJECT_0) {
+            CancelIoEx(pipe, &overlapped);
+            GetOverlappedResult(pipe, &overlapped, &read, TRUE);
+            dropConnection("read timed out");
+            return false;
         }
     }
-#else
-    if (read(sock, &opcode, sizeof(opcode)) != sizeof(opcode)) {
-        return "";
+    if (!GetOverlappedResult(pipe, &overlapped, &read, FALSE)) {
+        dropConnection("read failed");
+        return false;
     }
-    if (read(sock, &length, sizeof(length)) != sizeof(length)) {
-        return "";
+    receiveEnd += read;
+#else
+    ssize_t n = recv(sock, receiveBuffer + receiveEnd, space, MSG_DONTWAIT);
+    if (n == 0) {
+        dropConnection("closed by Discord");
+        return false;
     }
-    
-    if (length > 0 && length < 65536) { // Sanity check
-        std::vector<char> buffer(length + 1);
-        if (read(sock, buffer.data(), length) == static_cast<ssize_t>(length)) {
-            buffer[length] = '\0';
-            return std::string(buffer.data());
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return true;
         }
+        dropConnection("connection reset");
+        return false;
     }
+    receiveEnd += static_cast<size_t>(n);
 #endif
-    return "";
+    // Any traffic proves the link is alive
+    lastReceive = clock.now();
+    pingOutstanding = false;
+    return true;
 }
 
-bool DiscordRPC::connect() {
-#ifdef _WIN32
-    // Try connecting to Discord IPC pipes (discord-ipc-0 through discord-ipc-9)
-    for (int i = 0; i < 10; i++) {
-        std::string pipeName = "\\\\.\\pipe\\discord-ipc-" + std::to_string(i);
-        
-        pipe = CreateFileA(
-            pipeName.c_str(),
-            GENERIC_READ | GENERIC_WRITE,
-            0,
-            nullptr,
-            OPEN_EXISTING,
-            0,
-            nullptr
-        );
-        
-        if (pipe != INVALID_HANDLE_VALUE) {
-            connected = true;
-            break;
-        }
+bool DiscordRPC::nextFrame(uint32_t& opcode, std::string_view& body) {
+    size_t available = receiveEnd - receiveStart;
+    if (available < 8) {
+        return false;
     }
-#else
-    // Try connecting to Discord IPC sockets on Unix
-    for (int i = 0; i < 10; i++) {
-        sock = socket(AF_UNIX, SOCK_STREAM, 0);
-        if (sock == -1) continue;
-        
-        struct sockaddr_un addr;
-        memset(&addr, 0, sizeof(addr));
-        addr.sun_family = AF_UNIX;
+    
+    uint32_t length;
+    std::memcpy(&opcode, receiveBuffer + receiveStart, sizeof(opcode));
+    std::memcpy(&length, receiveBuffer + receiveStart + 4, sizeof(length));
+    if (length > RECEIVE_BUFFER_SIZE - 8) {
+        // Can never fit, and the rest of the stream can't be framed without it
+        dropConnection("oversized frame");
+        return false;
+    }
+    if (available < 8 + length) {
+        return false;
+    }
+    
+    body = std::string_view(receiveBuffer + receiveStart + 8, length);
+    receiveStart += 8 + length;
+    return true;
+}
+
+void DiscordRPC::completeRequest(const DiscordResponse& response) {
+    // Oldest unread response is overwritten if the caller never drains them
+    size_t slot = (completedHead + completedCount) % MAX_PENDING;
+    completed[slot] = response;
+    if (completedCount < MAX_PENDING) {
+        completedCount++;
+    } else {
+        completedHead = (completedHead + 1) % MAX_PENDING;
+    }
+}
+
+void DiscordRPC::handleFrame(uint32_t opcode, std::string_view body, TickArena& arena) {
+    if (opcode == OP_PING) {
+        // Echo the payload back
+        ArenaWriter pong(arena, body.size() + 8);
+        beginFrame(pong);
+        pong += body;
+        writeMessage(finishFrame(pong, OP_PONG));
+        return;
+    }
+    
+    if (opcode == OP_CLOSE) {
+        dropConnection("closed by Discord");
+        return;
+    }
+    
+    // PONG needs no handling: receiving it already refreshed lastReceive
+    if (opcode != OP_FRAME) {
+        return;
+    }
+    
+    FrameFields fields;
+    if (!parseFrameFields(body, arena, fields) || fields.nonce.empty()) {
+        return;  // DISPATCH events carry no nonce
+    }
+    
+    uint64_t nonce = 0;
+    std::from_chars(fields.nonce.data(), fields.nonce.data() + fields.nonce.size(), nonce);
+    
+    for (size_t i = 0; i < MAX_PENDING; i++) {
+        if (pending[i].nonce == 0 || pending[i].nonce != nonce) {
+            continue;
+        }
         
-        std::string socketPath;
-        const char* tmpdir = getenv("XDG_RUNTIME_DIR");
-        if (!tmpdir) tmpdir = getenv("TMPDIR");
-        if (!tmpdir) tmpdir = "/tmp";
+        requestLatency.record(microsecondsBetween(pending[i].sentAt, clock.now()));
         
-        socketPath = std::string(tmpdir) + "/discord-ipc-" + std::to_string(i);
-        strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+        DiscordResponse response;
+        response.nonce = nonce;
+        response.command = pending[i].command;
+        response.ok = fields.evt != "ERROR";
+        if (!response.ok) {
+            // {"code": 4000, "message": "..."}
+            FlatJsonReader data(fields.data.data(), fields.data.size());
+            std::string_view key;
+            std::string_view message;
+            double code;
+            while (data.nextKey(key)) {
+                if (key == "code") {
+                    if (data.readNumber(code)) response.errorCode = static_cast<int>(code);
+                } else if (key == "message") {
+                    if (data.readString(arena, message)) response.errorMessage.assign(message);
+                } else {
+                    data.skipValue();
+                }
+            }
+        }
         
-        if (::connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
-            connected = true;
+        pending[i].nonce = 0;
+        pendingCount--;
+        completeRequest(response);
+        return;
+    }
+}
+
+bool DiscordRPC::sendCommand(DiscordCommand command, uint64_t nonce, std::string_view frame) {
+    // Find a free slot first so a full table sends nothing
+    size_t slot = MAX_PENDING;
+    for (size_t i = 0; i < MAX_PENDING; i++) {
+        if (pending[i].nonce == 0) {
+            slot = i;
             break;
         }
-        
-        close(sock);
-        sock = -1;
     }
+    if (slot == MAX_PENDING || !writeMessage(frame)) {
+        return false;
+    }
+    
+    pending[slot].nonce = nonce;
+    pending[slot].command = command;
+    pending[slot].sentAt = clock.now();
+    pendingCount++;
+    return true;
+}
+
+bool DiscordRPC::connect(IpcConnector& connector, TickArena& arena) {
+    if (connected) {
+        return true;
+    }
+    
+    TraceScope trace(Tracer::Span::Connect);
+    
+    // One budget covers opening the endpoint, the handshake and READY
+    IoClock::time_point started = IoClock::now();
+    auto deadline = started + std::chrono::milliseconds(timeouts.handshakeMs);
+    
+#ifdef _WIN32
+    connected = connector.open(pipe);
+#else
+    connected = connector.open(sock);
 #endif
     
     if (!connected) {
         return false;
     }
     
-    // Send handshake
-    std::string handshake = createHandshakeMessage();
-    writeMessage(handshake, 0);  // Opcode 0 for handshake
+    // Fresh connection: nothing from the previous one can still be answered
+    for (size_t i = 0; i < MAX_PENDING; i++) {
+        pending[i].nonce = 0;
+    }
+    pendingCount = 0;
+    completedHead = completedCount = 0;
+    hasQueued = false;
+    receiveStart = receiveEnd = 0;
+    lastReceive = clock.now();
+    pingOutstanding = false;
+    
+    // Send handshake and wait for the READY dispatch
+    if (!writeMessage(createHandshakeMessage(arena))) {
+        disconnect();
+        return false;
+    }
     
-    // Read response
-    std::string response = readMessage();
-    return !response.empty();
+    while (connected) {
+        uint32_t opcode;
+        std::string_view body;
+        while (nextFrame(opcode, body)) {
+            FrameFields fields;
+            if (opcode == OP_FRAME && parseFrameFields(body, arena, fields) && fields.evt == "READY") {
+                connectLatency.record(microsecondsBetween(started, IoClock::now()));
+                return true;
+            }
+            // An invalid client ID, for one; waiting longer won't bring READY
+            if (opcode == OP_FRAME && fields.evt == "ERROR") {
+                dropConnection("handshake rejected");
+                return false;
+            }
+            if (opcode == OP_CLOSE) {
+                dropConnection("closed by Discord");
+                return false;
+            }
+        }
+        if (!connected) {
+            // nextFrame() dropped it (oversized frame)
+            return false;
+        }
+        
+        int remaining = millisecondsUntil(deadline);
+        if (remaining <= 0 || !waitReadable(remaining)) {
+            dropConnection("handshake timed out");
+            return false;
+        }
+        if (!fillReceiveBuffer()) {
+            // EOF or a read error, with the reason already recorded
+            return false;
+        }
+    }
+    
+    return false;
 }
 
 void DiscordRPC::disconnect() {
@@ -251,37 +566,215 @@ void DiscordRPC::disconnect() {
         }
 #endif
         connected = false;
+        disconnectReason = "disconnected";
     }
 }
 
-bool DiscordRPC::updateActivity(const DiscordActivity& activity) {
-    if (!connected) return false;
+uint64_t DiscordRPC::sendActivity(const DiscordActivity& activity, TickArena& arena) {
+    if (!connected) return 0;
+    
+    uint64_t nonce = nextNonce++;
+    std::string_view frame;
+    {
+        TraceScope trace(Tracer::Span::Serialize);
+        frame = createActivityMessage(activity, nonce, arena);
+    }
+    if (!sendCommand(DiscordCommand::SetActivity, nonce, frame)) {
+        return 0;
+    }
+    return nonce;
+}
+
+uint64_t DiscordRPC::sendClearActivity(TickArena& arena) {
+    if (!connected) return 0;
+    
+    uint64_t nonce = nextNonce++;
+    std::string_view frame;
+    {
+        TraceScope trace(Tracer::Span::Serialize);
+        frame = createClearActivityMessage(nonce, arena);
+    }
+    if (!sendCommand(DiscordCommand::ClearActivity, nonce, frame)) {
+        return 0;
+    }
+    return nonce;
+}
+
+void DiscordRPC::queueActivity(const DiscordActivity& activity, PresencePriority priority) {
+    if (hasQueued) {
+        droppedUpdates++;
+        // A clear that is replaced by an activity no longer matters; anything
+        // else hands its urgency on, since the new snapshot includes its change
+        if (queuedPriority == PresencePriority::Clear || priority > queuedPriority) {
+            queuedPriority = priority;
+        }
+    } else {
+        queuedPriority = priority;
+    }
+    queuedActivity = activity;
+    hasQueued = true;
+}
+
+void DiscordRPC::queueClearActivity() {
+    if (hasQueued) {
+        droppedUpdates++;
+    }
+    queuedPriority = PresencePriority::Clear;
+    hasQueued = true;
+}
+
+uint64_t DiscordRPC::flushQueue(TickArena& arena) {
+    if (!hasQueued || !connected) {
+        return 0;
+    }
     
-    std::string activityJson = createActivityMessage(activity);
-    writeMessage(activityJson, 1);  // Opcode 1 for frame
+    // Only detail updates respect back-pressure
+    if (queuedPriority == PresencePriority::Detail && pendingCount > 0) {
+        return 0;
+    }
     
-    // Read response
-    std::string response = readMessage();
-    return !response.empty();
+    uint64_t nonce = queuedPriority == PresencePriority::Clear
+        ? sendClearActivity(arena)
+        : sendActivity(queuedActivity, arena);
+    if (nonce != 0) {
+        hasQueued = false;
+    }
+    return nonce;
 }
 
-bool DiscordRPC::clearActivity() {
+bool DiscordRPC::pollResponses(TickArena& arena) {
     if (!connected) return false;
     
-    std::string clearJson = createClearActivityMessage();
-    writeMessage(clearJson, 1);  // Opcode 1 for frame
+    TraceScope trace(Tracer::Span::ResponsePoll);
     
-    // Read response
-    std::string response = readMessage();
-    return !response.empty();
+#ifdef _WIN32
+    if (!fillReceiveBuffer()) {
+        return false;
+    }
+#else
+    // One zero-timeout poll reports data, EOF (HUP) and socket errors; recv
+    // only runs when there is something to read
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, 0) > 0) {
+        if (pfd.revents & (POLLERR | POLLNVAL)) {
+            dropConnection("connection error");
+            return false;
+        }
+        if (!fillReceiveBuffer()) {
+            return false;
+        }
+    }
+#endif
+    
+    uint32_t opcode;
+    std::string_view body;
+    while (connected && nextFrame(opcode, body)) {
+        handleFrame(opcode, body, arena);
+    }
+    
+    if (connected) {
+        checkLiveness(arena);
+    }
+    return connected;
+}
+
+void DiscordRPC::sendPing(TickArena& arena) {
+    // Discord echoes the payload back in a PONG
+    ArenaWriter ping(arena, 16);
+    beginFrame(ping);
+    ping += std::string_view("{}");
+    if (writeMessage(finishFrame(ping, OP_PING))) {
+        pingSentAt = clock.now();
+        pingOutstanding = true;
+    }
+}
+
+void DiscordRPC::checkLiveness(TickArena& arena) {
+    auto now = clock.now();
+    
+    // Fail requests Discord never answered
+    bool requestTimedOut = false;
+    for (size_t i = 0; i < MAX_PENDING && pendingCount > 0; i++) {
+        if (pending[i].nonce == 0 || now - pending[i].sentAt < std::chrono::milliseconds(timeouts.requestMs)) {
+            continue;
+        }
+        
+        DiscordResponse response;
+        response.nonce = pending[i].nonce;
+        response.command = pending[i].command;
+        response.ok = false;
+        response.errorCode = DiscordResponse::ERROR_TIMED_OUT;
+        response.errorMessage.assign("Request timed out");
+        pending[i].nonce = 0;
+        pendingCount--;
+        timedOutRequests++;
+        completeRequest(response);
+        requestTimedOut = true;
+    }
+    
+    if (pingOutstanding) {
+        if (now - pingSentAt >= std::chrono::milliseconds(timeouts.pingMs)) {
+            dropConnection("ping timed out");
+        }
+        return;
+    }
+    
+    // Probe a link that has gone quiet, or that just lost a request
+    if (requestTimedOut || now - lastReceive >= std::chrono::milliseconds(IDLE_PING_MS)) {
+        sendPing(arena);
+    }
+}
+
+bool DiscordRPC::nextResponse(DiscordResponse& response) {
+    if (completedCount == 0) {
+        return false;
+    }
+    response = completed[completedHead];
+    completedHead = (completedHead + 1) % MAX_PENDING;
+    completedCount--;
+    return true;
+}
+
+bool DiscordRPC::waitForResponse(uint64_t nonce, int timeoutMs, TickArena& arena) {
+    TraceScope trace(Tracer::Span::ResponseWait);
+    auto deadline = IoClock::now() + std::chrono::milliseconds(timeoutMs);
+    
+    for (;;) {
+        if (!pollResponses(arena)) {
+            return false;
+        }
+        
+        // Look for the nonce among completed responses without consuming the others
+        for (size_t i = 0; i < completedCount; i++) {
+            const DiscordResponse& response = completed[(completedHead + i) % MAX_PENDING];
+            if (response.nonce == nonce) {
+                return response.ok;
+            }
+        }
+        
+        int remaining = millisecondsUntil(deadline);
+        if (remaining <= 0 || !waitReadable(remaining)) {
+            return false;
+        }
+    }
+}
+
+bool DiscordRPC::updateActivity(const DiscordActivity& activity, TickArena& arena) {
+    uint64_t nonce = sendActivity(activity, arena);
+    return nonce != 0 && waitForResponse(nonce, timeouts.requestMs, arena);
+}
+
+bool DiscordRPC::clearActivity(TickArena& arena) {
+    // Goes through the queue so that nothing queued is sent after it
+    queueClearActivity();
+    uint64_t nonce = flushQueue(arena);
+    return nonce != 0 && waitForResponse(nonce, timeouts.requestMs, arena);
 }
 
 bool DiscordRPC::isConnected() const {
     return connected;
 }
 
-long long DiscordRPC::getCurrentTimestamp() {
-    return std::chrono::duration_cast<std::chrono::seconds>(
-        std::chrono::system_clock::now().time_since_epoch()
-    ).count();
-}
\ No newline at end of file
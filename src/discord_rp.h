@@ -2,6 +2,15 @@
 #define DISCORD_RP_H
 
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <chrono>
+#include "arena.h"
+#include "clock.h"
+#include "presence.h"
+#include "presence_template.h"
+#include "ipc_connector.h"
+#include "latency.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -10,21 +19,100 @@
 #include <sys/un.h>
 #endif
 
+/**
+ * Compact presence snapshot. Display text and asset keys are not stored; they
+ * are rendered from the interned table in presence.h and the PresenceFormat
+ * templates when the frame is built.
+ */
 struct DiscordActivity {
-    std::string state;
-    std::string details;
-    std::string largeImage;
-    std::string largeText;
-    std::string smallImage;
-    std::string smallText;
+    static const size_t MAX_TEXT = 128;  // Discord's limit for activity strings
+    
+    PresenceState state;
+    int bpm;
+    InlineString<MAX_TEXT> plugin;
+    InlineString<MAX_TEXT> projectName;
     long long startTime;
     long long endTime;
+    int cpuPercent;                     // FL Studio's usage, -1/0 unless a template shows it
+    int memoryMb;
+    
+    DiscordActivity()
+        : state(PresenceState::Starting), bpm(0), startTime(0), endTime(0), cpuPercent(-1), memoryMb(0) {}
+    
+    bool operator==(const DiscordActivity& other) const {
+        return state == other.state && bpm == other.bpm &&
+               startTime == other.startTime && endTime == other.endTime &&
+               cpuPercent == other.cpuPercent && memoryMb == other.memoryMb &&
+               plugin == other.plugin && projectName == other.projectName;
+    }
+    bool operator!=(const DiscordActivity& other) const { return !(*this == other); }
+    
+    uint64_t hash() const {
+        uint64_t h = fnv1a(&state, sizeof(state));
+        h = fnv1a(&bpm, sizeof(bpm), h);
+        h = fnv1a(&startTime, sizeof(startTime), h);
+        h = fnv1a(&endTime, sizeof(endTime), h);
+        h = fnv1a(&cpuPercent, sizeof(cpuPercent), h);
+        h = fnv1a(&memoryMb, sizeof(memoryMb), h);
+        h = fnv1a(plugin.view().data(), plugin.size(), h);
+        return fnv1a(projectName.view().data(), projectName.size(), h);
+    }
+};
+
+/**
+ * Time budgets for IPC operations. Nothing waits on Discord longer than these.
+ */
+struct DiscordTimeouts {
+    int handshakeMs;    // Opening the endpoint until READY
+    int requestMs;      // A command until its response
+    int ioMs;           // A single frame write (or read, on Windows)
+    int pingMs;         // A liveness ping until any reply
     
-    DiscordActivity() : startTime(0), endTime(0) {}
+    DiscordTimeouts() : handshakeMs(3000), requestMs(5000), ioMs(1000), pingMs(5000) {}
+};
+
+/**
+ * Urgency of a queued presence change. Higher values preempt lower ones.
+ */
+enum class PresencePriority : uint8_t {
+    Detail,     // BPM/plugin changes: wait until the previous update is answered
+    State,      // Recording/Listening/... transitions: sent straight away
+    Clear       // FL Studio exited: sent straight away, replaces everything queued
+};
+
+enum class DiscordCommand : uint8_t {
+    SetActivity,
+    ClearActivity
+};
+
+/**
+ * Outcome of a command, matched to its request by nonce
+ */
+struct DiscordResponse {
+    static const int ERROR_TIMED_OUT = -1;  // errorCode when Discord never answered
+    
+    uint64_t nonce;
+    DiscordCommand command;
+    bool ok;
+    int errorCode;                      // Discord RPC error code when !ok
+    InlineString<128> errorMessage;
+    
+    DiscordResponse() : nonce(0), command(DiscordCommand::SetActivity), ok(false), errorCode(0) {}
 };
 
 class DiscordRPC {
+public:
+    static const size_t MAX_PENDING = 8;
+    
 private:
+    struct PendingRequest {
+        uint64_t nonce;                 // 0 = free slot
+        DiscordCommand command;
+        Clock::TimePoint sentAt;
+    };
+    
+    static const size_t RECEIVE_BUFFER_SIZE = 16 * 1024;
+    
 #ifdef _WIN32
     HANDLE pipe;
 #else
@@ -32,25 +120,140 @@ private:
 #endif
     bool connected;
     std::string clientId;
+    DiscordTimeouts timeouts;
+    PresenceFormat format;              // Activity text templates
+    Clock& clock;                       // Request timeouts and liveness pings
+#ifdef _WIN32
+    HANDLE ioEvent;                     // Completion event for overlapped pipe I/O
+#endif
+    std::string_view disconnectReason;  // Why the last connection ended
+    
+    // Liveness: idle links are pinged, and a ping or request that goes
+    // unanswered marks the link dead
+    Clock::TimePoint lastReceive;
+    Clock::TimePoint pingSentAt;
+    bool pingOutstanding;
+    uint64_t timedOutRequests;
+    
+    LatencyHistogram connectLatency;    // Endpoint open through READY
+    LatencyHistogram requestLatency;    // Command sent until its response is read (polled once per tick)
+    
+    // Nonces are unique for the lifetime of the object, across reconnects
+    uint64_t nextNonce;
+    PendingRequest pending[MAX_PENDING];
+    size_t pendingCount;
+    
+    // Responses completed by pollResponses(), drained with nextResponse()
+    DiscordResponse completed[MAX_PENDING];
+    size_t completedHead;
+    size_t completedCount;
     
-    std::string createHandshakeMessage();
-    std::string createActivityMessage(const DiscordActivity& activity);
-    std::string createClearActivityMessage();
-    void writeMessage(const std::string& message, int opcode = 1);
-    std::string readMessage();
+    // Outbound presence: one latest-wins slot. Every entry is a full snapshot,
+    // so a newer one makes the queued one stale whatever its category; the
+    // slot keeps the highest priority of the entries it absorbed.
+    bool hasQueued;
+    PresencePriority queuedPriority;
+    DiscordActivity queuedActivity;     // Unused for Clear
+    uint64_t droppedUpdates;            // Replaced before they were serialized
+    
+    // Incoming bytes; complete frames are parsed from the front
+    char receiveBuffer[RECEIVE_BUFFER_SIZE];
+    size_t receiveStart;
+    size_t receiveEnd;
+    
+    // Frames are built in the arena with the 8-byte header reserved up front,
+    // then sent with a single write
+    std::string_view createHandshakeMessage(TickArena& arena);
+    std::string_view createActivityMessage(const DiscordActivity& activity, uint64_t nonce, TickArena& arena);
+    std::string_view createClearActivityMessage(uint64_t nonce, TickArena& arena);
+    bool writeMessage(std::string_view frame);
+    void dropConnection(std::string_view reason);
+    void checkLiveness(TickArena& arena);
+    void sendPing(TickArena& arena);
+    
+    bool sendCommand(DiscordCommand command, uint64_t nonce, std::string_view frame);
+    bool waitReadable(int timeoutMs);
+    bool fillReceiveBuffer();
+    bool nextFrame(uint32_t& opcode, std::string_view& body);
+    void handleFrame(uint32_t opcode, std::string_view body, TickArena& arena);
+    void completeRequest(const DiscordResponse& response);
 
 public:
-    DiscordRPC(const std::string& clientId);
+    DiscordRPC(const std::string& clientId, const DiscordTimeouts& timeouts = DiscordTimeouts(),
+               const PresenceFormat& format = PresenceFormat(), Clock& clock = Clock::system());
     ~DiscordRPC();
     
-    bool connect();
+    // Scratch memory for frames and responses comes from the caller's arena
+    bool connect(IpcConnector& connector, TickArena& arena);
     void disconnect();
-    bool updateActivity(const DiscordActivity& activity);
-    bool clearActivity();
+    
+    /**
+     * @brief Send SET_ACTIVITY without waiting for the response
+     * @return Nonce of the request, 0 if it could not be sent
+     */
+    uint64_t sendActivity(const DiscordActivity& activity, TickArena& arena);
+    
+    /**
+     * @brief Send SET_ACTIVITY with a null activity without waiting for the response
+     * @return Nonce of the request, 0 if it could not be sent
+     */
+    uint64_t sendClearActivity(TickArena& arena);
+    
+    /**
+     * @brief Read and dispatch whatever frames have arrived, without blocking
+     * @return false if the connection was closed
+     */
+    bool pollResponses(TickArena& arena);
+    
+    /**
+     * @brief Take the next completed response
+     * @return false if none are waiting
+     */
+    bool nextResponse(DiscordResponse& response);
+    
+    /**
+     * @brief Block until the request with this nonce completes
+     * @return true if it completed successfully within the timeout
+     */
+    bool waitForResponse(uint64_t nonce, int timeoutMs, TickArena& arena);
+    
+    /**
+     * @brief Queue an activity, replacing whatever is queued
+     * Nothing is serialized until flushQueue() sends it.
+     */
+    void queueActivity(const DiscordActivity& activity, PresencePriority priority);
+    
+    /**
+     * @brief Queue a clear, replacing whatever is queued
+     */
+    void queueClearActivity();
+    
+    /**
+     * @brief Send the queued entry if flow control allows
+     * Detail updates wait until no SET_ACTIVITY is awaiting its response, so
+     * a slow Discord only ever receives the latest one. State changes and
+     * clears go out at once; the stream keeps them in order.
+     * @return Nonce of the request sent, 0 if nothing was sent
+     */
+    uint64_t flushQueue(TickArena& arena);
+    
+    bool hasQueuedUpdate() const { return hasQueued; }
+    uint64_t droppedUpdateCount() const { return droppedUpdates; }
+    
+    // Blocking helpers: send and wait (up to the request budget) for the matching response
+    bool updateActivity(const DiscordActivity& activity, TickArena& arena);
+    bool clearActivity(TickArena& arena);
+    
     bool isConnected() const;
+    size_t pendingRequests() const { return pendingCount; }
+    uint64_t timedOutRequestCount() const { return timedOutRequests; }
+    const LatencyHistogram& connectLatencies() const { return connectLatency; }
+    const LatencyHistogram& requestLatencies() const { return requestLatency; }
     
-    // Static helper to get current timestamp
-    static long long getCurrentTimestamp();
+    /**
+     * @brief Why the connection was last closed ("closed by Discord", "ping timed out", ...)
+     */
+    std::string_view lastDisconnectReason() const { return disconnectReason; }
 };
 
 #endif // DISCORD_RP_H
\ No newline at end of file
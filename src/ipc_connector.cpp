@@ -0,0 +1,372 @@
+#include "ipc_connector.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+IpcConnector::IpcConnector(Clock& clock)
+    : m_clock(clock)
+    , m_preferred(-1)
+    , m_opened(-1)
+    , m_failures(0)
+    , m_nextAttempt(clock.now())
+    , m_random(static_cast<std::minstd_rand::result_type>(
+          clock.now().time_since_epoch().count())) {
+#ifdef _WIN32
+    for (int i = 0; i < ENDPOINT_COUNT; i++) {
+        std::snprintf(m_names[i], sizeof(m_names[i]), "\\\\.\\pipe\\discord-ipc-%d", i);
+    }
+#else
+    const char* tmpdir = getenv("XDG_RUNTIME_DIR");
+    if (!tmpdir) tmpdir = getenv("TMPDIR");
+    if (!tmpdir) tmpdir = "/tmp";
+
+    // Socket dirs first so their index matches WatchDir::socketDir
+    static const char* const subdirs[WATCH_DIR_COUNT] = {
+        "",
+        "/app/com.discordapp.Discord",  // Flatpak
+        "/snap.discord",                // Snap
+        "/app"                          // Parent of the Flatpak dir, watched for its creation
+    };
+    for (int d = 0; d < WATCH_DIR_COUNT; d++) {
+        std::snprintf(m_watchDirs[d].path, sizeof(m_watchDirs[d].path), "%s%s", tmpdir, subdirs[d]);
+        m_watchDirs[d].socketDir = d < SOCKET_DIR_COUNT ? d : -1;
+        m_watchDirs[d].wd = -1;
+    }
+
+    for (int d = 0; d < SOCKET_DIR_COUNT; d++) {
+        for (int i = 0; i < ENDPOINT_COUNT; i++) {
+            struct sockaddr_un& addr = m_addresses[d * ENDPOINT_COUNT + i];
+            std::memset(&addr, 0, sizeof(addr));
+            int length = std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/discord-ipc-%d", m_watchDirs[d].path, i);
+            // Paths that don't fit in sun_path can't be connected to; leave them AF_UNSPEC
+            if (length > 0 && static_cast<size_t>(length) < sizeof(addr.sun_path)) {
+                addr.sun_family = AF_UNIX;
+            }
+        }
+    }
+
+    m_waitingForEndpoint = false;
+    m_endpointAppeared = false;
+    m_sawLiveEndpoint = false;
+    m_hint = -1;
+    m_retryHint = -1;
+    m_hintRetries = 0;
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    addWatches();
+#endif
+}
+
+IpcConnector::~IpcConnector() {
+#ifndef _WIN32
+    if (m_inotify != -1) {
+        close(m_inotify);
+    }
+#endif
+}
+
+#ifdef _WIN32
+
+bool IpcConnector::tryEndpoint(int index, IpcHandle& handle) {
+    // Overlapped so DiscordRPC can put a deadline on every read and write
+    handle = CreateFileA(m_names[index], GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    return handle != INVALID_HANDLE_VALUE;
+}
+
+bool IpcConnector::attemptDue() {
+    return m_clock.now() >= m_nextAttempt;
+}
+
+bool IpcConnector::waitingForEndpoint() const {
+    return false;
+}
+
+bool IpcConnector::waitForEndpoint(int timeoutMs, WakeEvent& interrupt) {
+    // Named pipes can't be watched; just wait for the next timed attempt
+    m_clock.wait(interrupt, timeoutMs);
+    return false;
+}
+
+#else
+
+// Passed by reference to std::chrono, so it needs a definition
+const int IpcConnector::HINT_RETRY_MS;
+
+// handle is a non-blocking probe socket. A failed AF_UNIX connect leaves it
+// unconnected, so the same socket is reused for the next endpoint.
+bool IpcConnector::tryEndpoint(int index, IpcHandle& handle) {
+    const struct sockaddr_un& addr = m_addresses[index];
+    if (handle == -1 || addr.sun_family != AF_UNIX) {
+        return false;
+    }
+    if (::connect(handle, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr)) == 0) {
+        return true;
+    }
+
+    // ENOENT (no such endpoint), ECONNREFUSED (stale socket file) and EAGAIN
+    // (backlog full) leave the socket reusable; anything else gets a fresh one
+    if (errno == EAGAIN) {
+        m_sawLiveEndpoint = true;
+    }
+    if (errno != ENOENT && errno != ENOTDIR && errno != ECONNREFUSED && errno != EAGAIN) {
+        close(handle);
+        handle = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    return false;
+}
+
+void IpcConnector::addWatches() {
+    if (m_inotify == -1) {
+        return;
+    }
+    for (int d = 0; d < WATCH_DIR_COUNT; d++) {
+        WatchDir& dir = m_watchDirs[d];
+        if (dir.wd != -1) {
+            continue;
+        }
+        // Fails with ENOENT until the directory exists; its parent's watch reports the creation
+        dir.wd = inotify_add_watch(m_inotify, dir.path, IN_CREATE | IN_MOVED_TO | IN_ONLYDIR);
+        if (dir.wd != -1 && dir.socketDir >= 0 && m_waitingForEndpoint) {
+            // An endpoint may have been created before the watch was in place
+            m_endpointAppeared = true;
+        }
+    }
+}
+
+void IpcConnector::drainEvents() {
+    if (m_inotify == -1) {
+        return;
+    }
+
+    alignas(struct inotify_event) char buffer[4096];
+    bool rescan = false;
+    for (;;) {
+        ssize_t n = read(m_inotify, buffer, sizeof(buffer));
+        if (n <= 0) {
+            break;
+        }
+
+        for (char* p = buffer; p < buffer + n; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & (IN_IGNORED | IN_Q_OVERFLOW)) {
+                // Watched directory was removed, or events were lost
+                for (int d = 0; d < WATCH_DIR_COUNT; d++) {
+                    if (m_watchDirs[d].wd == event->wd) {
+                        m_watchDirs[d].wd = -1;
+                    }
+                }
+                m_endpointAppeared = m_endpointAppeared || (event->mask & IN_Q_OVERFLOW);
+                rescan = true;
+                continue;
+            }
+            if (event->mask & IN_ISDIR) {
+                rescan = true;
+                continue;
+            }
+            if (event->len == 0 || std::strncmp(event->name, "discord-ipc-", 12) != 0) {
+                continue;
+            }
+
+            int endpoint = event->name[12] - '0';
+            if (endpoint < 0 || endpoint >= ENDPOINT_COUNT || event->name[13] != '\0') {
+                continue;
+            }
+            for (int d = 0; d < WATCH_DIR_COUNT; d++) {
+                if (m_watchDirs[d].wd == event->wd && m_watchDirs[d].socketDir >= 0) {
+                    m_hint = m_watchDirs[d].socketDir * ENDPOINT_COUNT + endpoint;
+                    m_hintRetries = HINT_RETRIES;
+                    m_endpointAppeared = true;
+                }
+            }
+        }
+    }
+
+    if (rescan) {
+        addWatches();
+    }
+}
+
+bool IpcConnector::attemptDue() {
+    if (m_waitingForEndpoint) {
+        drainEvents();
+        if (!m_endpointAppeared) {
+            return false;
+        }
+        m_waitingForEndpoint = false;
+        m_endpointAppeared = false;
+        return true;
+    }
+    return m_clock.now() >= m_nextAttempt;
+}
+
+bool IpcConnector::waitingForEndpoint() const {
+    return m_waitingForEndpoint;
+}
+
+bool IpcConnector::waitForEndpoint(int timeoutMs, WakeEvent& interrupt) {
+    // Once an endpoint has appeared, sleep until the next attempt consumes it.
+    // Simulated time can't pass in a poll() on inotify, so it just moves on.
+    if (!m_waitingForEndpoint || m_endpointAppeared || !m_clock.realTime()) {
+        m_clock.wait(interrupt, timeoutMs);
+        return false;
+    }
+
+    // Unrelated files come and go in the runtime dir; keep waiting through them
+    auto deadline = m_clock.now() + std::chrono::milliseconds(timeoutMs);
+    for (;;) {
+        drainEvents();
+        if (m_endpointAppeared) {
+            return true;
+        }
+        int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - m_clock.now()).count());
+        if (remaining <= 0) {
+            return false;
+        }
+
+        struct pollfd pfds[2];
+        pfds[0].fd = m_inotify;
+        pfds[0].events = POLLIN;
+        pfds[0].revents = 0;
+        pfds[1].fd = interrupt.fd();
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        if (::poll(pfds, 2, remaining) <= 0) {
+            return false;
+        }
+        if (pfds[1].revents & POLLIN) {
+            interrupt.clear();
+            return false;
+        }
+    }
+}
+
+#endif
+
+long long IpcConnector::retryDelayMs() const {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        m_nextAttempt - m_clock.now()).count();
+    return remaining > 0 ? remaining : 0;
+}
+
+bool IpcConnector::open(IpcHandle& handle) {
+    m_opened = -1;
+#ifdef _WIN32
+    IpcHandle probe = INVALID_IPC_HANDLE;
+#else
+    // Anything created before this sweep is about to be tried; keep only the hint
+    drainEvents();
+    m_endpointAppeared = false;
+    m_sawLiveEndpoint = false;
+    IpcHandle probe = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (probe == -1) {
+        return false;
+    }
+#endif
+
+    // The endpoint that was just created, then the last working one, then the rest in order
+    int first = m_preferred;
+    int second = -1;
+#ifndef _WIN32
+    int hint = m_hint;
+    m_hint = -1;
+    m_retryHint = -1;
+    if (hint >= 0) {
+        first = hint;
+        second = hint != m_preferred ? m_preferred : -1;
+    }
+#endif
+
+    int found = -1;
+    if (first >= 0 && tryEndpoint(first, probe)) {
+        found = first;
+    }
+#ifndef _WIN32
+    // A socket reported by inotify is bound but may not be listening yet;
+    // recordResult() schedules another try shortly rather than waiting here
+    if (found < 0 && hint >= 0 && m_hintRetries > 0) {
+        m_retryHint = hint;
+        m_hintRetries--;
+    }
+#endif
+    if (found < 0 && second >= 0 && tryEndpoint(second, probe)) {
+        found = second;
+    }
+    for (int i = 0; found < 0 && i < CANDIDATE_COUNT; i++) {
+        if (i != first && i != second && tryEndpoint(i, probe)) {
+            found = i;
+        }
+    }
+
+    if (found < 0) {
+#ifndef _WIN32
+        if (probe != -1) {
+            close(probe);
+        }
+#endif
+        return false;
+    }
+
+    m_opened = found;
+    handle = probe;
+    return true;
+}
+
+void IpcConnector::recordResult(bool success) {
+    if (success) {
+        m_preferred = m_opened;
+        m_failures = 0;
+        m_nextAttempt = m_clock.now();
+        return;
+    }
+
+#ifndef _WIN32
+    // Discord is starting: its endpoint exists but isn't listening yet
+    if (m_opened < 0 && m_retryHint >= 0) {
+        m_hint = m_retryHint;
+        m_retryHint = -1;
+        m_nextAttempt = m_clock.now() + std::chrono::milliseconds(HINT_RETRY_MS);
+        return;
+    }
+
+    // Discord isn't running: nothing is listening, so nothing can succeed until
+    // an endpoint is created. Discord replaces stale socket files when it
+    // starts, which is reported as a creation too. A busy endpoint or a failed
+    // handshake means Discord is up, so those retry on the timer.
+    if (m_opened < 0 && !m_sawLiveEndpoint && m_inotify != -1) {
+        // Picks up anything created while the sweep was running
+        m_waitingForEndpoint = true;
+        drainEvents();
+        return;
+    }
+#endif
+
+    // Equal jitter: wait between half and all of the exponential delay so a
+    // restarted Discord isn't hit by every client at the same moment
+    if (m_failures < 16) {
+        m_failures++;
+    }
+    long long delay = static_cast<long long>(BACKOFF_INITIAL_MS) << (m_failures - 1);
+    if (delay > BACKOFF_MAX_MS) {
+        delay = BACKOFF_MAX_MS;
+    }
+    std::uniform_int_distribution<long long> jitter(delay / 2, delay);
+    m_nextAttempt = m_clock.now() + std::chrono::milliseconds(jitter(m_random));
+}
+
+void IpcConnector::resetBackoff() {
+    m_failures = 0;
+    m_nextAttempt = m_clock.now();
+#ifndef _WIN32
+    m_waitingForEndpoint = false;
+#endif
+}
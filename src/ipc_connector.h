@@ -0,0 +1,137 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "clock.h"
+#include "wake_event.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/un.h>
+#endif
+
+#ifdef _WIN32
+typedef HANDLE IpcHandle;
+#define INVALID_IPC_HANDLE INVALID_HANDLE_VALUE
+#else
+typedef int IpcHandle;
+#define INVALID_IPC_HANDLE (-1)
+#endif
+
+/**
+ * @brief Finds and opens Discord's IPC endpoint (discord-ipc-0..9)
+ *
+ * Outlives individual DiscordRPC connections so that reconnects start with
+ * the endpoint that worked last time, and so failed attempts back off
+ * exponentially (with jitter) instead of sweeping every endpoint each tick.
+ * Endpoint names are resolved once at construction.
+ *
+ * On Linux the runtime directory and the Flatpak and Snap subdirectories
+ * Discord uses are watched with inotify. While no endpoint exists, attempts
+ * wait for a discord-ipc-N socket to be created instead of a timer.
+ */
+class IpcConnector {
+    public:
+        static const int ENDPOINT_COUNT = 10;
+        static const int BACKOFF_INITIAL_MS = 500;
+        static const int BACKOFF_MAX_MS = 30000;
+
+    private:
+#ifdef _WIN32
+        static const int CANDIDATE_COUNT = ENDPOINT_COUNT;
+        char m_names[ENDPOINT_COUNT][32];
+#else
+        // Directories that may hold endpoints: the runtime dir, Flatpak, Snap
+        static const int SOCKET_DIR_COUNT = 3;
+        static const int CANDIDATE_COUNT = SOCKET_DIR_COUNT * ENDPOINT_COUNT;
+        // Watched directories: the socket dirs plus the Flatpak "app" parent
+        static const int WATCH_DIR_COUNT = SOCKET_DIR_COUNT + 1;
+        // Retries, HINT_RETRY_MS apart, for an endpoint that was created but
+        // refused the first connect; each one is a separate attempt
+        static const int HINT_RETRIES = 5;
+        static const int HINT_RETRY_MS = 10;
+
+        struct WatchDir {
+            char path[sizeof(sockaddr_un::sun_path)];
+            int socketDir;      // Index into the socket dirs, -1 for a parent only
+            int wd;             // inotify watch, -1 if not watched (yet)
+        };
+
+        struct sockaddr_un m_addresses[CANDIDATE_COUNT];
+        WatchDir m_watchDirs[WATCH_DIR_COUNT];
+        int m_inotify;              // -1 if inotify is unavailable
+        bool m_waitingForEndpoint;  // Last sweep found no endpoint; wait for one to appear
+        bool m_endpointAppeared;
+        bool m_sawLiveEndpoint;     // Some endpoint was listening but didn't accept during the last sweep
+        int m_hint;                 // Endpoint most recently created, -1 if none
+        int m_retryHint;            // Created endpoint the last sweep was refused by, -1 if none
+        int m_hintRetries;          // Retries left for the created endpoint
+
+        void addWatches();
+        void drainEvents();
+#endif
+        Clock& m_clock;
+        int m_preferred;        // Endpoint that last completed a handshake, -1 if none
+        int m_opened;           // Endpoint returned by the last successful open(), -1 if it failed
+
+        int m_failures;         // Consecutive failed attempts
+        Clock::TimePoint m_nextAttempt;
+        std::minstd_rand m_random;
+
+        bool tryEndpoint(int index, IpcHandle& handle);
+
+    public:
+        explicit IpcConnector(Clock& clock = Clock::system());
+        ~IpcConnector();
+
+        IpcConnector(const IpcConnector&) = delete;
+        IpcConnector& operator=(const IpcConnector&) = delete;
+
+        /**
+         * @brief Whether a new attempt should be made now
+         * True once the backoff delay has passed or, while waiting for Discord
+         * to start, once an endpoint has been created.
+         */
+        bool attemptDue();
+
+        /**
+         * @brief Open the most promising endpoint, falling back to a sweep of the others
+         * @param handle Receives the open endpoint: a non-blocking socket, or a pipe opened for overlapped I/O
+         * @return true if an endpoint accepted the connection
+         */
+        bool open(IpcHandle& handle);
+
+        /**
+         * @brief Record the outcome of a connection attempt, including the handshake
+         * Success remembers the endpoint and resets the backoff; failure doubles it.
+         */
+        void recordResult(bool success);
+
+        /**
+         * @brief Allow the next attempt immediately (user-requested reconnect)
+         */
+        void resetBackoff();
+
+        /**
+         * @brief Whether attempts are paused until an endpoint is created
+         */
+        bool waitingForEndpoint() const;
+
+        /**
+         * @brief Block until an endpoint is created, interrupt is signaled or the timeout passes
+         * Only waits on interrupt when not waiting for an endpoint, or when
+         * one has already appeared and not been attempted yet.
+         * @return true if an endpoint appeared
+         */
+        bool waitForEndpoint(int timeoutMs, WakeEvent& interrupt);
+
+        int preferredEndpoint() const { return m_preferred; }
+        int failures() const { return m_failures; }
+
+        /**
+         * @brief Milliseconds until the next timed attempt is due, 0 if it already is
+         */
+        long long retryDelayMs() const;
+};
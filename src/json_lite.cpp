@@ -0,0 +1,298 @@
+#include "json_lite.h"
+#include <cstring>
+
+namespace {
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(const char*& pos, const char* end, unsigned& out) {
+    if (end - pos < 4) return false;
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        int v = hexValue(pos[i]);
+        if (v < 0) return false;
+        out = (out << 4) | static_cast<unsigned>(v);
+    }
+    pos += 4;
+    return true;
+}
+
+// Encodes cp at dst and returns the byte count (at most 4)
+size_t encodeUtf8(char* dst, unsigned cp) {
+    if (cp < 0x80) {
+        dst[0] = static_cast<char>(cp);
+        return 1;
+    } else if (cp < 0x800) {
+        dst[0] = static_cast<char>(0xC0 | (cp >> 6));
+        dst[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        dst[0] = static_cast<char>(0xE0 | (cp >> 12));
+        dst[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = static_cast<char>(0xF0 | (cp >> 18));
+    dst[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+} // namespace
+
+FlatJsonReader::FlatJsonReader(const char* data, size_t size)
+    : m_pos(data)
+    , m_end(data + size)
+    , m_started(false)
+    , m_failed(false) {
+}
+
+void FlatJsonReader::skipWhitespace() {
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n' || *m_pos == '\r')) {
+        ++m_pos;
+    }
+}
+
+bool FlatJsonReader::expect(char c) {
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == c) {
+        ++m_pos;
+        return true;
+    }
+    m_failed = true;
+    return false;
+}
+
+bool FlatJsonReader::skipString() {
+    // Assumes m_pos is on the opening quote
+    ++m_pos;
+    while (m_pos < m_end) {
+        if (*m_pos == '\\') {
+            if (m_end - m_pos < 2) break;
+            m_pos += 2;
+        } else if (*m_pos == '"') {
+            ++m_pos;
+            return true;
+        } else {
+            ++m_pos;
+        }
+    }
+    m_failed = true;
+    return false;
+}
+
+bool FlatJsonReader::readRawKey(std::string_view& key) {
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '"') {
+        m_failed = true;
+        return false;
+    }
+    const char* start = m_pos + 1;
+    if (!skipString()) return false;
+    key = std::string_view(start, static_cast<size_t>(m_pos - 1 - start));
+    return expect(':');
+}
+
+bool FlatJsonReader::nextKey(std::string_view& key) {
+    if (m_failed) return false;
+
+    if (!m_started) {
+        m_started = true;
+        if (!expect('{')) return false;
+        skipWhitespace();
+        if (m_pos < m_end && *m_pos == '}') {
+            ++m_pos;
+            return false;
+        }
+        return readRawKey(key);
+    }
+
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == ',') {
+        ++m_pos;
+        return readRawKey(key);
+    }
+    if (m_pos < m_end && *m_pos == '}') {
+        ++m_pos;
+        return false;
+    }
+    m_failed = true;
+    return false;
+}
+
+bool FlatJsonReader::readString(TickArena& arena, std::string_view& out) {
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '"') {
+        skipValue();
+        return false;
+    }
+
+    // Decoded text is never longer than the raw text: \uXXXX (6 bytes) decodes
+    // to at most 3, and a surrogate pair (12 bytes) to 4
+    const char* raw = m_pos + 1;
+    if (!skipString()) return false;
+    size_t rawLength = static_cast<size_t>(m_pos - 1 - raw);
+    if (std::memchr(raw, '\\', rawLength) == nullptr) {
+        out = arena.copy(std::string_view(raw, rawLength));
+        return true;
+    }
+
+    char* dst = arena.allocateChars(rawLength);
+    size_t length = 0;
+    const char* p = raw;
+    const char* end = raw + rawLength;
+    while (p < end) {
+        char c = *p++;
+        if (c != '\\') {
+            dst[length++] = c;
+            continue;
+        }
+
+        char esc = *p++;
+        switch (esc) {
+            case '"':  dst[length++] = '"';  break;
+            case '\\': dst[length++] = '\\'; break;
+            case '/':  dst[length++] = '/';  break;
+            case 'b':  dst[length++] = '\b'; break;
+            case 'f':  dst[length++] = '\f'; break;
+            case 'n':  dst[length++] = '\n'; break;
+            case 'r':  dst[length++] = '\r'; break;
+            case 't':  dst[length++] = '\t'; break;
+            case 'u': {
+                unsigned cp;
+                if (!readHex4(p, end, cp)) {
+                    m_failed = true;
+                    return false;
+                }
+                // Python's json.dump escapes non-BMP characters as surrogate pairs
+                if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    const char* low = p + 2;
+                    unsigned lo;
+                    if (readHex4(low, end, lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                        p = low;
+                    }
+                }
+                // An unpaired half has no UTF-8 encoding; U+FFFD (3 bytes) fits its 6
+                if (cp >= 0xD800 && cp <= 0xDFFF) {
+                    cp = 0xFFFD;
+                }
+                length += encodeUtf8(dst + length, cp);
+                break;
+            }
+            default:
+                m_failed = true;
+                return false;
+        }
+    }
+
+    out = std::string_view(dst, length);
+    return true;
+}
+
+bool FlatJsonReader::readNumber(double& out) {
+    skipWhitespace();
+    const char* p = m_pos;
+    bool negative = false;
+    if (p < m_end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if (p >= m_end || *p < '0' || *p > '9') {
+        skipValue();
+        return false;
+    }
+
+    double value = 0.0;
+    while (p < m_end && *p >= '0' && *p <= '9') {
+        value = value * 10.0 + (*p++ - '0');
+    }
+    if (p < m_end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < m_end && *p >= '0' && *p <= '9') {
+            value += (*p++ - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negExp = false;
+        if (p < m_end && (*p == '+' || *p == '-')) {
+            negExp = (*p == '-');
+            ++p;
+        }
+        int exp = 0;
+        while (p < m_end && *p >= '0' && *p <= '9') {
+            exp = exp * 10 + (*p++ - '0');
+            if (exp > 308) exp = 308;
+        }
+        double factor = 1.0;
+        while (exp-- > 0) factor *= 10.0;
+        value = negExp ? value / factor : value * factor;
+    }
+
+    m_pos = p;
+    out = negative ? -value : value;
+    return true;
+}
+
+bool FlatJsonReader::skipValue() {
+    skipWhitespace();
+    if (m_pos >= m_end) {
+        m_failed = true;
+        return false;
+    }
+
+    if (*m_pos == '"') {
+        return skipString();
+    }
+
+    if (*m_pos == '{' || *m_pos == '[') {
+        int depth = 0;
+        while (m_pos < m_end) {
+            char c = *m_pos;
+            if (c == '"') {
+                if (!skipString()) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    ++m_pos;
+                    return true;
+                }
+            }
+            ++m_pos;
+        }
+        m_failed = true;
+        return false;
+    }
+
+    // Number or literal (true/false/null)
+    const char* start = m_pos;
+    while (m_pos < m_end && *m_pos != ',' && *m_pos != '}' && *m_pos != ']' &&
+           *m_pos != ' ' && *m_pos != '\t' && *m_pos != '\n' && *m_pos != '\r') {
+        ++m_pos;
+    }
+    if (m_pos == start) {
+        m_failed = true;
+        return false;
+    }
+    return true;
+}
+
+bool FlatJsonReader::readRaw(std::string_view& raw) {
+    skipWhitespace();
+    const char* start = m_pos;
+    if (!skipValue()) return false;
+    raw = std::string_view(start, static_cast<size_t>(m_pos - start));
+    return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <string_view>
+#include <cstddef>
+#include "arena.h"
+
+/**
+ * @brief Forward-only reader for flat JSON objects
+ *
+ * Reads the FL Studio state file (one object of strings and numbers) without
+ * building a DOM. Members are visited in file order; values the caller does
+ * not care about are skipped with skipValue().
+ */
+class FlatJsonReader {
+    private:
+        const char* m_pos;
+        const char* m_end;
+        bool m_started;
+        bool m_failed;
+
+        void skipWhitespace();
+        bool expect(char c);
+        bool skipString();
+        bool readRawKey(std::string_view& key);
+
+    public:
+        FlatJsonReader(const char* data, size_t size);
+
+        /**
+         * @brief Advance to the next member of the top-level object
+         * @param key Receives the raw (unescaped) member name
+         * @return true if a member is available, false at the end or on malformed input
+         */
+        bool nextKey(std::string_view& key);
+
+        /**
+         * @brief Read the current value as a string, decoding escapes to UTF-8
+         * An unpaired surrogate escape decodes to U+FFFD.
+         * @param arena Arena the decoded text is written to
+         * @param out Receives the decoded text, valid until the arena is reset
+         * @return true if the value was a string, false otherwise (the value is skipped)
+         */
+        bool readString(TickArena& arena, std::string_view& out);
+
+        /**
+         * @brief Read the current value as a number
+         * @return true if the value was a number, false otherwise (the value is skipped)
+         */
+        bool readNumber(double& out);
+
+        /**
+         * @brief Skip the current value, including nested objects and arrays
+         */
+        bool skipValue();
+
+        /**
+         * @brief Skip the current value and return its raw text
+         * Nested objects can then be read with a FlatJsonReader of their own.
+         */
+        bool readRaw(std::string_view& raw);
+
+        bool failed() const { return m_failed; }
+};
+
+/**
+ * @brief Append a value escaped for use inside a JSON string, without quotes
+ * @param out std::string or ArenaWriter
+ */
+template <typename Out>
+void appendJsonEscaped(Out& out, std::string_view value) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    size_t runStart = 0;
+    for (size_t i = 0; i < value.size(); i++) {
+        char c = value[i];
+        if (c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20) {
+            continue;
+        }
+
+        // Flush the unescaped run before the escape
+        out += value.substr(runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':  out += std::string_view("\\\""); break;
+            case '\\': out += std::string_view("\\\\"); break;
+            case '\n': out += std::string_view("\\n");  break;
+            case '\r': out += std::string_view("\\r");  break;
+            case '\t': out += std::string_view("\\t");  break;
+            default:
+                out += std::string_view("\\u00");
+                out += hexDigits[(c >> 4) & 0xF];
+                out += hexDigits[c & 0xF];
+        }
+    }
+    out += value.substr(runStart);
+}
+
+/**
+ * @brief Append a value as a quoted JSON string, escaping as required
+ * @param out std::string or ArenaWriter
+ */
+template <typename Out>
+void appendJsonString(Out& out, std::string_view value) {
+    out += '"';
+    appendJsonEscaped(out, value);
+    out += '"';
+}
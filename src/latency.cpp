@@ -0,0 +1,67 @@
+#include "latency.h"
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+void LatencyHistogram::record(uint64_t micros) {
+    size_t bucket = 0;
+    while (bucket < BUCKETS - 1 && micros >= (1ull << bucket)) {
+        bucket++;
+    }
+    m_counts[bucket]++;
+    m_total++;
+    if (micros > m_maxMicros) {
+        m_maxMicros = micros;
+    }
+}
+
+void LatencyHistogram::clear() {
+    for (size_t i = 0; i < BUCKETS; i++) {
+        m_counts[i] = 0;
+    }
+    m_total = 0;
+    m_maxMicros = 0;
+}
+
+uint64_t LatencyHistogram::percentileMicros(double percentile) const {
+    if (m_total == 0) {
+        return 0;
+    }
+
+    // Rank of the sample at this percentile, counted from 1
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > m_total) rank = m_total;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += m_counts[i];
+        if (seen >= rank) {
+            // The maximum is a tighter bound for the top bucket, and the only one for the last
+            uint64_t bound = 1ull << i;
+            return i == BUCKETS - 1 || bound > m_maxMicros ? m_maxMicros : bound;
+        }
+    }
+    return m_maxMicros;
+}
+
+LatencySummary LatencyHistogram::summarize() const {
+    LatencySummary result;
+    result.count = m_total;
+    result.p50Micros = percentileMicros(50);
+    result.p99Micros = percentileMicros(99);
+    result.maxMicros = m_maxMicros;
+    return result;
+}
+
+std::string LatencyHistogram::summary() const {
+    char line[128];
+    std::snprintf(line, sizeof(line), "n=%llu p50<=%.1fms p99<=%.1fms max=%.1fms",
+                  static_cast<unsigned long long>(m_total),
+                  percentileMicros(50) / 1000.0,
+                  percentileMicros(99) / 1000.0,
+                  m_maxMicros / 1000.0);
+    return line;
+}
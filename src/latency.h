@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Percentiles of a LatencyHistogram, small enough to publish in a status snapshot
+ */
+struct LatencySummary {
+    uint64_t count;
+    uint64_t p50Micros;
+    uint64_t p99Micros;
+    uint64_t maxMicros;
+
+    LatencySummary() : count(0), p50Micros(0), p99Micros(0), maxMicros(0) {}
+
+    bool operator==(const LatencySummary& other) const {
+        return count == other.count && p50Micros == other.p50Micros &&
+               p99Micros == other.p99Micros && maxMicros == other.maxMicros;
+    }
+    bool operator!=(const LatencySummary& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Fixed-size latency histogram with power-of-two microsecond buckets
+ *
+ * Bucket i counts samples below 2^i microseconds (bucket 0 also takes 0),
+ * the last bucket everything above. Recording is a few instructions and
+ * never allocates, so it can sit on every request.
+ */
+class LatencyHistogram {
+    public:
+        static const size_t BUCKETS = 24;   // Last bounded bucket: < ~8.4s
+
+    private:
+        uint64_t m_counts[BUCKETS];
+        uint64_t m_total;
+        uint64_t m_maxMicros;
+
+    public:
+        LatencyHistogram();
+
+        void record(uint64_t micros);
+        void clear();
+
+        uint64_t count() const { return m_total; }
+        uint64_t maxMicros() const { return m_maxMicros; }
+
+        /**
+         * @brief Upper bound of the bucket holding the given percentile (0-100)
+         * @return Microseconds, 0 if empty
+         */
+        uint64_t percentileMicros(double percentile) const;
+
+        LatencySummary summarize() const;
+
+        /**
+         * @brief One-line summary: "n=12 p50<=1.0ms p99<=4.1ms max=3.2ms"
+         */
+        std::string summary() const;
+};
@@ -0,0 +1,340 @@
+#include "logger.h"
+#include "presence.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const size_t RING_SIZE = 512;   // Power of two
+const size_t RING_MASK = RING_SIZE - 1;
+
+// Bounded MPSC ring: each cell's sequence says whose turn it is. A producer
+// claims position p when the cell's sequence is p and hands it to the
+// consumer by setting it to p + 1; the consumer frees it with p + RING_SIZE.
+struct alignas(64) Cell {
+    std::atomic<size_t> sequence;
+    LogRecord record;
+};
+
+Cell g_cells[RING_SIZE];
+alignas(64) std::atomic<size_t> g_enqueuePos{0};
+alignas(64) size_t g_dequeuePos = 0;    // Drain thread only
+std::atomic<uint64_t> g_dropped{0};
+std::atomic<uint64_t> g_emitted{0};    // Messages queued, for the repeat gap
+
+// Wakes the drain thread. Only the first message after the thread went to
+// sleep notifies, and producers don't take the mutex, so a notify can be
+// missed; the drain then falls back to its timeout.
+std::mutex g_wakeMutex;
+std::condition_variable g_wake;
+std::atomic<bool> g_drainSleeping{false};
+std::atomic<bool> g_stopRequested{false};
+std::atomic<bool> g_deferred{false};
+std::thread g_drainThread;
+LogLevel g_outputLevel = LogLevel::Debug;
+const int DRAIN_TIMEOUT_MS = 1000;
+// After a wakeup, let the rest of a burst arrive before draining
+const int DRAIN_BATCH_MS = 5;
+
+// Cells start out free for the first lap: sequence == index
+struct RingInit {
+    RingInit() {
+        for (size_t i = 0; i < RING_SIZE; i++) {
+            g_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+} g_ringInit;
+
+bool push(const LogRecord& record) {
+    size_t pos = g_enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+        cell = &g_cells[pos & RING_MASK];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (g_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   // Full: the consumer hasn't freed this cell yet
+        } else {
+            pos = g_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Header and the used part of the payload only
+    std::memcpy(&cell->record, &record, offsetof(LogRecord, payload) + record.size);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+const LogRecord* front() {
+    Cell& cell = g_cells[g_dequeuePos & RING_MASK];
+    if (cell.sequence.load(std::memory_order_acquire) != g_dequeuePos + 1) {
+        return nullptr;
+    }
+    return &cell.record;
+}
+
+void popFront() {
+    g_cells[g_dequeuePos & RING_MASK].sequence.store(g_dequeuePos + RING_SIZE, std::memory_order_release);
+    g_dequeuePos++;
+}
+
+const char* levelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO ";
+        case LogLevel::Warn:  return "WARN ";
+        case LogLevel::Error: return "ERROR";
+    }
+    return "?    ";
+}
+
+void appendTimestamp(std::string& out, int64_t timeNs) {
+    std::time_t seconds = static_cast<std::time_t>(timeNs / 1000000000);
+    int millis = static_cast<int>((timeNs / 1000000) % 1000);
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d.%03d ", local.tm_hour, local.tm_min, local.tm_sec, millis);
+    out += buffer;
+}
+
+// Appends the next argument, advancing offset; false once the payload is used up
+bool appendArg(std::string& out, const LogRecord& record, size_t& offset) {
+    if (offset >= record.size) {
+        return false;
+    }
+    LogRecord::ArgType type = static_cast<LogRecord::ArgType>(record.payload[offset++]);
+    const unsigned char* value = record.payload + offset;
+    char buffer[32];
+
+    switch (type) {
+        case LogRecord::ArgType::Int: {
+            int64_t v;
+            std::memcpy(&v, value, sizeof(v));
+            offset += sizeof(v);
+            std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(v));
+            out += buffer;
+            return true;
+        }
+        case LogRecord::ArgType::UInt: {
+            uint64_t v;
+            std::memcpy(&v, value, sizeof(v));
+            offset += sizeof(v);
+            std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(v));
+            out += buffer;
+            return true;
+        }
+        case LogRecord::ArgType::Double: {
+            double v;
+            std::memcpy(&v, value, sizeof(v));
+            offset += sizeof(v);
+            std::snprintf(buffer, sizeof(buffer), "%g", v);
+            out += buffer;
+            return true;
+        }
+        case LogRecord::ArgType::Bool: {
+            bool v;
+            std::memcpy(&v, value, sizeof(v));
+            offset += sizeof(v);
+            out += v ? "true" : "false";
+            return true;
+        }
+        case LogRecord::ArgType::String: {
+            uint16_t length;
+            std::memcpy(&length, value, sizeof(length));
+            offset += sizeof(length);
+            out.append(reinterpret_cast<const char*>(record.payload + offset), length);
+            offset += length;
+            return true;
+        }
+    }
+    return false;
+}
+
+void format(std::string& out, const LogRecord& record) {
+    appendTimestamp(out, record.timeNs);
+    out += levelTag(record.level);
+    out += ' ';
+
+    if (!record.format) {
+        out += "(previous message from this call site repeated ";
+        out += std::to_string(record.repeats);
+        out += " more times)\n";
+        return;
+    }
+
+    size_t offset = 0;
+    for (const char* p = record.format; *p; p++) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (!appendArg(out, record, offset)) {
+                out += "{}";
+            }
+            p++;
+        } else {
+            out += *p;
+        }
+    }
+    if (record.truncated) {
+        out += " [truncated]";
+    }
+    // Multi-line reports already end in a newline
+    if (out.back() != '\n') {
+        out += '\n';
+    }
+}
+
+// Messages queued and not drained yet (drain thread only)
+size_t queued() {
+    return g_enqueuePos.load(std::memory_order_relaxed) - g_dequeuePos;
+}
+
+// Returns true if anything was written
+bool drain(std::string& line) {
+    bool wrote = false;
+    while (const LogRecord* record = front()) {
+        if (record->level >= g_outputLevel) {
+            line.clear();
+            format(line, *record);
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            wrote = true;
+        }
+        popFront();
+    }
+
+    uint64_t dropped = g_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        std::fprintf(stdout, "%llu log messages dropped (buffer full)\n", static_cast<unsigned long long>(dropped));
+        wrote = true;
+    }
+    if (wrote) {
+        std::fflush(stdout);
+    }
+    return wrote;
+}
+
+void drainLoop() {
+    std::string line;
+    line.reserve(LogRecord::PAYLOAD_SIZE * 2);
+    while (!g_stopRequested.load()) {
+        if (!g_deferred.load() || queued() >= RING_SIZE / 2) {
+            drain(line);
+        }
+        {
+            std::unique_lock<std::mutex> lock(g_wakeMutex);
+            g_drainSleeping.store(true);
+            g_wake.wait_for(lock, std::chrono::milliseconds(DRAIN_TIMEOUT_MS), [] {
+                return g_stopRequested.load() || (!g_deferred.load() && front() != nullptr);
+            });
+            g_drainSleeping.store(false);
+        }
+        if (!g_stopRequested.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_BATCH_MS));
+        }
+    }
+    drain(line);
+}
+
+} // namespace
+
+int64_t Logger::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void Logger::submit(LogSite& site, const LogRecord& record) {
+    uint64_t hash = fnv1a(&record.level, sizeof(record.level));
+    hash = fnv1a(&record.format, sizeof(record.format), hash);
+    hash = fnv1a(record.payload, record.size, hash);
+
+    // Races between threads logging from the same site only blur the count
+    int64_t window = static_cast<int64_t>(REPEAT_WINDOW_MS) * 1000000;
+    uint64_t gap = g_emitted.load(std::memory_order_relaxed) - site.lastSerial.load(std::memory_order_relaxed);
+    if (hash == site.lastHash.load(std::memory_order_relaxed) &&
+        record.timeNs - site.lastTimeNs.load(std::memory_order_relaxed) < window &&
+        gap <= static_cast<uint64_t>(REPEAT_GAP)) {
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    uint32_t repeats = site.suppressed.exchange(0, std::memory_order_relaxed);
+    if (repeats > 0) {
+        LogRecord notice;
+        notice.format = nullptr;
+        notice.timeNs = record.timeNs;
+        notice.repeats = repeats;
+        notice.level = record.level;
+        notice.truncated = false;
+        notice.size = 0;
+        if (!push(notice)) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    site.lastHash.store(hash, std::memory_order_relaxed);
+    site.lastTimeNs.store(record.timeNs, std::memory_order_relaxed);
+    site.lastSerial.store(g_emitted.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (!push(record)) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Deferred messages wait for the drain thread's timeout
+    if (!g_deferred.load(std::memory_order_relaxed) &&
+        g_drainSleeping.load(std::memory_order_relaxed) && g_drainSleeping.exchange(false)) {
+        g_wake.notify_one();
+    }
+}
+
+void Logger::start(LogLevel minLevel) {
+    s_minLevel.store(static_cast<uint8_t>(minLevel), std::memory_order_relaxed);
+    if (g_drainThread.joinable()) {
+        return;
+    }
+    // Set before the thread exists, so it needs no synchronization
+    g_outputLevel = minLevel;
+    g_stopRequested.store(false);
+    g_drainThread = std::thread(drainLoop);
+}
+
+void Logger::setDeferred(bool deferred) {
+    {
+        std::lock_guard<std::mutex> lock(g_wakeMutex);
+        g_deferred.store(deferred);
+    }
+    if (!deferred) {
+        g_wake.notify_one();
+    }
+}
+
+void Logger::stop() {
+    if (!g_drainThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(g_wakeMutex);
+        g_stopRequested.store(true);
+    }
+    g_wake.notify_one();
+    g_drainThread.join();
+}
+
+namespace {
+
+// Destroyed before the ring and the thread above: writes what main's locals
+// (AppState's shutdown in particular) logged after main returned
+struct StopAtExit {
+    ~StopAtExit() { Logger::stop(); }
+} g_stopAtExit;
+
+} // namespace
@@ -0,0 +1,200 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+enum class LogLevel : uint8_t {
+    Debug,
+    Info,
+    Warn,
+    Error
+};
+
+/**
+ * @brief One message in binary form: format string pointer plus encoded arguments
+ *
+ * Arguments are stored as a type tag followed by the raw value (strings as
+ * a length and their bytes); the drain thread turns them into text.
+ */
+struct LogRecord {
+    static const size_t PAYLOAD_SIZE = 464;
+
+    enum class ArgType : uint8_t {
+        Int,
+        UInt,
+        Double,
+        Bool,
+        String
+    };
+
+    const char* format;         // String literal with {} placeholders; null for a repeat notice
+    int64_t timeNs;             // system_clock, formatted by the drain thread
+    uint32_t repeats;           // Repeat notice: times the previous message was suppressed
+    LogLevel level;
+    bool truncated;             // Arguments didn't fit in the payload
+    uint16_t size;
+    unsigned char payload[PAYLOAD_SIZE];
+
+    bool reserve(size_t bytes) {
+        if (size + bytes > PAYLOAD_SIZE) {
+            truncated = true;
+            return false;
+        }
+        return true;
+    }
+
+    void put(ArgType type, const void* value, size_t bytes) {
+        if (!reserve(1 + bytes)) {
+            return;
+        }
+        payload[size++] = static_cast<unsigned char>(type);
+        std::memcpy(payload + size, value, bytes);
+        size += static_cast<uint16_t>(bytes);
+    }
+
+    void putString(std::string_view text) {
+        // Long strings keep as much as fits, cut at a UTF-8 character boundary
+        if (!reserve(1 + sizeof(uint16_t) + 1)) {
+            return;
+        }
+        size_t room = PAYLOAD_SIZE - size - 1 - sizeof(uint16_t);
+        if (text.size() > room) {
+            while (room > 0 && (static_cast<unsigned char>(text[room]) & 0xC0) == 0x80) {
+                room--;
+            }
+            text = text.substr(0, room);
+            truncated = true;
+        }
+        uint16_t length = static_cast<uint16_t>(text.size());
+        payload[size++] = static_cast<unsigned char>(ArgType::String);
+        std::memcpy(payload + size, &length, sizeof(length));
+        size += sizeof(length);
+        std::memcpy(payload + size, text.data(), text.size());
+        size += length;
+    }
+};
+
+/**
+ * @brief Per call site state for repeat suppression, created by the LOG_* macros
+ */
+struct LogSite {
+    std::atomic<uint64_t> lastHash;
+    std::atomic<int64_t> lastTimeNs;
+    std::atomic<uint64_t> lastSerial;   // Messages queued when this site last logged
+    std::atomic<uint32_t> suppressed;
+
+    constexpr LogSite() : lastHash(0), lastTimeNs(0), lastSerial(0), suppressed(0) {}
+};
+
+/**
+ * @brief Asynchronous logger: producers encode, a background thread formats and writes
+ *
+ * Logging a message copies the format pointer and the binary arguments
+ * into a bounded lock-free ring (multi-producer, single consumer); nothing
+ * is formatted, flushed or locked on the calling thread. When the ring is
+ * full the message is dropped and counted rather than waiting.
+ *
+ * A call site that repeats the same message (same arguments) within
+ * REPEAT_WINDOW_MS, with at most REPEAT_GAP other messages logged in
+ * between, logs it once; the repeats are reported before the next message
+ * from that site, like syslog's "last message repeated N times". The gap
+ * lets per-tick messages that alternate be suppressed, while an event that
+ * recurs after other activity (a reconnect) is still logged.
+ *
+ * Messages logged before start() are kept and written once the drain
+ * thread runs, filtered by the level start() was given.
+ */
+class Logger {
+    public:
+        static const int REPEAT_WINDOW_MS = 10000;
+        static const int REPEAT_GAP = 1;
+
+        /**
+         * @brief Start the drain thread, writing to stdout
+         * @param minLevel Messages below this level are discarded
+         */
+        static void start(LogLevel minLevel);
+
+        /**
+         * @brief Write everything still queued and stop the drain thread
+         * Also runs at exit, after main's locals are destroyed.
+         */
+        static void stop();
+
+        /**
+         * @brief Hold messages in the ring instead of writing them (audio-safe mode)
+         * While deferred the drain thread only writes once the ring is half
+         * full; turning it off writes everything held.
+         */
+        static void setDeferred(bool deferred);
+
+        static bool enabled(LogLevel level) {
+            return static_cast<uint8_t>(level) >= s_minLevel.load(std::memory_order_relaxed);
+        }
+
+        template <typename... Args>
+        static void write(LogSite& site, LogLevel level, const char* format, const Args&... args) {
+            LogRecord record;
+            record.format = format;
+            record.timeNs = now();
+            record.repeats = 0;
+            record.level = level;
+            record.truncated = false;
+            record.size = 0;
+            (encode(record, args), ...);
+            submit(site, record);
+        }
+
+    private:
+        static inline std::atomic<uint8_t> s_minLevel{0};
+
+        static int64_t now();
+        static void submit(LogSite& site, const LogRecord& record);
+
+        static void encode(LogRecord& record, bool value) {
+            record.put(LogRecord::ArgType::Bool, &value, sizeof(value));
+        }
+        static void encode(LogRecord& record, double value) {
+            record.put(LogRecord::ArgType::Double, &value, sizeof(value));
+        }
+        static void encode(LogRecord& record, std::string_view value) {
+            record.putString(value);
+        }
+        static void encode(LogRecord& record, const char* value) {
+            record.putString(value ? std::string_view(value) : std::string_view("(null)"));
+        }
+        static void encode(LogRecord& record, const std::string& value) {
+            record.putString(value);
+        }
+        template <typename T>
+        static std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>> encode(LogRecord& record, T value) {
+            if (std::is_signed_v<T>) {
+                int64_t wide = static_cast<int64_t>(value);
+                record.put(LogRecord::ArgType::Int, &wide, sizeof(wide));
+            } else {
+                uint64_t wide = static_cast<uint64_t>(value);
+                record.put(LogRecord::ArgType::UInt, &wide, sizeof(wide));
+            }
+        }
+        template <typename T>
+        static std::enable_if_t<std::is_floating_point_v<T>> encode(LogRecord& record, T value) {
+            encode(record, static_cast<double>(value));
+        }
+};
+
+#define FLRP_LOG(level, ...) \
+    do { \
+        if (Logger::enabled(level)) { \
+            static LogSite flrpLogSite; \
+            Logger::write(flrpLogSite, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) FLRP_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) FLRP_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) FLRP_LOG(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) FLRP_LOG(LogLevel::Error, __VA_ARGS__)
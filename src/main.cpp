@@ -1,236 +1,260 @@
 #include "config.h"
-#include "monitor.h"
 #include "parser.h"
-#include "discord_rp.h"
 #include "app_state.h"
-#include "tray.h"
+#include "logger.h"
+#include "trace.h"
 #include <iostream>
-#include <thread>
-#include <chrono>
-#include <algorithm>
 #include <memory>
 #include <filesystem>
+
+#ifdef _WIN32
+#include "tray.h"
 #include <windows.h>
+#else
+#include "control_server.h"
+#include <csignal>
+#endif
+
+// Keeps the default template if the configured one doesn't compile
+static void loadPresenceTemplate(ConfigLoader& config, const std::string& key, PresenceTemplate& text) {
+    std::string source = config.getString(key, text.source());
+    std::string error;
+    if (!text.compile(source, error)) {
+        LOG_WARN("{}: {}, using \"{}\"", key, error, text.source());
+    }
+}
+
+// Load .env values into settings; returns false if the file is missing
+static bool loadSettings(ConfigLoader& config, AppSettings& settings) {
+    if (!config.loadEnvFile(".env")) {
+        return false;
+    }
+
+    settings.stateFilePath = config.getString("STATE_FILE_PATH", "NOT_FOUND");
+    PollPolicy& poll = settings.pollPolicy;
+    poll.idleMs = config.getInt("POLL_INTERVAL_MS", 999);
+    poll.activeMs = config.getInt("POLL_ACTIVE_INTERVAL_MS", poll.idleMs / 2);
+    poll.absentMaxMs = config.getInt("POLL_ABSENT_MAX_MS", poll.absentMaxMs);
+    poll.sampleMs = config.getInt("PROCESS_SAMPLE_MS", poll.sampleMs);
+    settings.debugMode = config.getBool("DEBUG_MODE", false);
+    settings.memoryStats = config.getBool("MEMORY_STATS", false);
+    settings.controlSocket = config.getString("CONTROL_SOCKET", "");
+    settings.traceEnabled = config.getBool("TRACE_ENABLED", false);
+    settings.traceFile = config.getString("TRACE_FILE", settings.traceFile);
+    settings.audioSafe = config.getBool("AUDIO_SAFE_MODE", settings.audioSafe);
+    settings.audioSafeCpu = config.getInt("AUDIO_SAFE_CPU", settings.audioSafeCpu);
+
+    DiscordTimeouts& timeouts = settings.discordTimeouts;
+    timeouts.handshakeMs = config.getInt("DISCORD_HANDSHAKE_TIMEOUT_MS", timeouts.handshakeMs);
+    timeouts.requestMs = config.getInt("DISCORD_REQUEST_TIMEOUT_MS", timeouts.requestMs);
+    timeouts.ioMs = config.getInt("DISCORD_IO_TIMEOUT_MS", timeouts.ioMs);
+    timeouts.pingMs = config.getInt("DISCORD_PING_TIMEOUT_MS", timeouts.pingMs);
 
+    CoalescePolicy& coalesce = settings.coalescePolicy;
+    coalesce.stateMs = config.getInt("PRESENCE_STATE_SETTLE_MS", coalesce.stateMs);
+    coalesce.bpmMs = config.getInt("PRESENCE_BPM_SETTLE_MS", coalesce.bpmMs);
+    coalesce.pluginMs = config.getInt("PRESENCE_PLUGIN_SETTLE_MS", coalesce.pluginMs);
+    coalesce.projectMs = config.getInt("PRESENCE_PROJECT_SETTLE_MS", coalesce.projectMs);
+
+    loadPresenceTemplate(config, "PRESENCE_DETAILS_TEMPLATE", settings.presenceFormat.details);
+    loadPresenceTemplate(config, "PRESENCE_STATE_TEMPLATE", settings.presenceFormat.state);
+
+    std::string processNames = config.getString("FL_PROCESS_NAMES", settings.processMatcher.source());
+    std::string error;
+    if (!settings.processMatcher.compile(processNames, error)) {
+        LOG_WARN("FL_PROCESS_NAMES: {}, using \"{}\"", error, settings.processMatcher.source());
+    }
+    config.setDebugMode(settings.debugMode);
+    return true;
+}
+
+static void printSettings(const AppSettings& settings) {
+    LOG_INFO("📋 Configuration Values:");
+    LOG_INFO("  DISCORD_APPLICATION_ID: {}", settings.discordId);
+    LOG_INFO("  STATE_FILE_PATH: {}", settings.stateFilePath);
+    LOG_INFO("  POLL_INTERVAL_MS: {} (active {}, absent up to {})",
+             settings.pollPolicy.idleMs, settings.pollPolicy.activeMs, settings.pollPolicy.absentMaxMs);
+    LOG_INFO("  PROCESS_SAMPLE_MS: {}", settings.pollPolicy.sampleMs);
+    LOG_INFO("  DEBUG_MODE: {}", settings.debugMode);
+    LOG_INFO("  MEMORY_STATS: {}", settings.memoryStats);
+    LOG_INFO("  CONTROL_SOCKET: {}", settings.controlSocket.empty() ? std::string("(disabled)") : settings.controlSocket);
+    LOG_INFO("  TRACE_ENABLED: {} ({})", settings.traceEnabled, settings.traceFile);
+    LOG_INFO("  AUDIO_SAFE_MODE: {} (CPU {})", settings.audioSafe, settings.audioSafeCpu);
+    LOG_INFO("  DISCORD_*_TIMEOUT_MS: handshake {}, request {}, io {}, ping {}",
+             settings.discordTimeouts.handshakeMs, settings.discordTimeouts.requestMs,
+             settings.discordTimeouts.ioMs, settings.discordTimeouts.pingMs);
+    LOG_INFO("  PRESENCE_*_SETTLE_MS: state {}, bpm {}, plugin {}, project {}",
+             settings.coalescePolicy.stateMs, settings.coalescePolicy.bpmMs,
+             settings.coalescePolicy.pluginMs, settings.coalescePolicy.projectMs);
+    LOG_INFO("  PRESENCE_DETAILS_TEMPLATE: {}", settings.presenceFormat.details.source());
+    LOG_INFO("  PRESENCE_STATE_TEMPLATE: {}", settings.presenceFormat.state.source());
+    LOG_INFO("  FL_PROCESS_NAMES: {}", settings.processMatcher.source());
+
+    if (FLParser::isFileAvailable(settings.stateFilePath)) {
+        LOG_INFO("✅ State file found!");
+    } else {
+        // Don't exit - AppState waits for FL Studio to start
+        LOG_INFO("❌ State file not found! Make sure FL Studio is running and the script is active.");
+    }
+}
+
+// Tracing can also be started later from the control socket
+static void startTracing(const AppSettings& settings) {
+    Tracer::setThreadName("main");
+    Tracer::setOutputPath(settings.traceFile);
+    if (settings.traceEnabled) {
+        Tracer::start();
+    }
+}
+
+// Writes the trace if one is still recording
+static void finishTracing() {
+    if (!Tracer::enabled()) {
+        return;
+    }
+    size_t events = 0;
+    if (Tracer::stop(events)) {
+        LOG_INFO("📈 Wrote {} trace spans to {}", events, Tracer::outputPath());
+    } else {
+        LOG_ERROR("Failed to write trace file {}", Tracer::outputPath());
+    }
+}
+
+#ifdef _WIN32
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd) {
-    // Discord RPC instance - managed with smart pointer
-    static std::unique_ptr<DiscordRPC> discord = nullptr;
-    static std::string discordId = "1396127471342194719";
-    static long long sessionStartTime = 0;
-    static bool shouldExit = false;
-    static bool userDisconnected = false;
-    
     // Load configuration
-    std::string stateFile = "Not_init";
-    int pollInterval = 999;
-    bool debugMode = false;
-
+    AppSettings settings;
     ConfigLoader config;
-    if (config.loadEnvFile(".env")) {
-        stateFile = config.getString("STATE_FILE_PATH", "NOT_FOUND");
-        pollInterval = config.getInt("POLL_INTERVAL_MS", 999);
-        debugMode = config.getBool("DEBUG_MODE", false);
-        config.setDebugMode(debugMode);
-        
-        // Allocate console only in debug mode
-        if (debugMode) {
-            AllocConsole();
-            freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
-            freopen_s((FILE**)stderr, "CONOUT$", "w", stderr);
-            freopen_s((FILE**)stdin, "CONIN$", "r", stdin);
-            std::ios::sync_with_stdio(true);
-            std::wcout.clear();
-            std::cout.clear();
-            std::wcerr.clear();
-            std::cerr.clear();
-            std::wcin.clear();
-            std::cin.clear();
-        }
-        
-        if (debugMode) {
-            std::cout << "\n📋 Configuration Values:" << std::endl;
-            std::cout << "  DISCORD_APPLICATION_ID: " << discordId << std::endl;
-            std::cout << "  STATE_FILE_PATH: " << stateFile << std::endl;
-            std::cout << "  POLL_INTERVAL_MS: " << pollInterval << std::endl;
-            std::cout << "  DEBUG_MODE: " << (debugMode ? "true" : "false") << std::endl;
-        }
-    } else {
-        if (debugMode) {
-            std::cout << "❌ Failed to load .env file!" << std::endl;
-        }
+    if (!loadSettings(config, settings)) {
         MessageBox(NULL, "Failed to load .env file! Please reinstall the application.", "FL Studio Rich Presence", MB_ICONERROR);
         return 1;
     }
 
-    // Initialize parser
-    if (FLParser::isFileAvailable(stateFile)) {
-        if (debugMode) {
-            std::cout << "✅ State file found!" << std::endl;
-        }
-    } else {
-        if (debugMode) {
-            std::cout << "❌ State file not found!" << std::endl;
-            std::cout << "Make sure FL Studio is running and the script is active." << std::endl;
-        }
-        // Don't exit immediately - let it run and wait for FL Studio to start
-        if (debugMode) {
-            std::cout << "Waiting for FL Studio to start..." << std::endl;
-        }
+    // Allocate console only in debug mode
+    if (settings.debugMode) {
+        AllocConsole();
+        freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
+        freopen_s((FILE**)stderr, "CONOUT$", "w", stderr);
+        freopen_s((FILE**)stdin, "CONIN$", "r", stdin);
+        std::ios::sync_with_stdio(true);
+        std::wcout.clear();
+        std::cout.clear();
+        std::wcerr.clear();
+        std::cerr.clear();
+        std::wcin.clear();
+        std::cin.clear();
     }
 
+    // Written by a background thread to the console allocated above
+    Logger::start(settings.debugMode ? LogLevel::Debug : LogLevel::Info);
+    if (settings.debugMode) {
+        printSettings(settings);
+    }
+    startTracing(settings);
+
+    AppState app;
+    app.initialize(settings);
+
     // Get executable directory and build icon path
     char exePath[MAX_PATH];
     GetModuleFileNameA(nullptr, exePath, MAX_PATH);
     std::filesystem::path executableDir = std::filesystem::path(exePath).parent_path();
     std::string iconPath = (executableDir / "FLRP.ico").string();
-    
+
     // Initialize system tray
     SystemTray tray;
     if (!tray.initialize(iconPath, "FL Studio Rich Presence")) {
-        if (debugMode) {
-            std::cout << "❌ Failed to initialize system tray!" << std::endl;
-            std::cout << "Continuing without system tray support..." << std::endl;
+        if (settings.debugMode) {
+            LOG_ERROR("❌ Failed to initialize system tray! Continuing without system tray support...");
         }
         // In non-debug mode, show error and exit since tray is essential for GUI-less app
-        if (!debugMode) {
+        if (!settings.debugMode) {
             MessageBox(NULL, "Failed to initialize system tray! The application will exit.", "FL Studio Rich Presence", MB_ICONERROR);
             return 1;
         }
     } else {
-        // Set up tray callbacks
+        // Set up tray callbacks; requests are applied by the next app.update()
         tray.setRefreshConnectionCallback([&]() {
-            if (discord && discord->isConnected()) {
-                discord->disconnect();
-            }
-            userDisconnected = false; // Allow reconnection after refresh
-            if (debugMode) {
-                std::cout << "🔄 Refreshing Discord connection..." << std::endl;
-            }
+            app.requestRefresh();
         });
-        
+
         tray.setDisconnectCallback([&]() {
-            if (discord && discord->isConnected()) {
-                discord->clearActivity();
-                discord->disconnect();
-                userDisconnected = true; // Prevent automatic reconnection
-                if (debugMode) {
-                    std::cout << "🔌 Disconnected from Discord (user requested)" << std::endl;
-                }
-            }
+            // Prevents automatic reconnection until refresh
+            app.requestDisconnect();
         });
-        
+
         tray.setExitCallback([&]() {
-            shouldExit = true;
-            if (debugMode) {
-                std::cout << "🚪 Exit requested from system tray" << std::endl;
-            }
+            app.requestExit();
         });
-        
+
         tray.show();
-        if (debugMode) {
-            std::cout << "✅ System tray initialized" << std::endl;
-        }
+        LOG_DEBUG("✅ System tray initialized");
     }
 
     // Main monitoring loop
-    ProcessMonitor monitor;
-    monitor.setDebugMode(debugMode);
-    
-    while (!shouldExit) {
-        if (monitor.searchForFLStudio()) {
-            if (debugMode) {
-                std::cout << "Found FL Studio running..." << std::endl;
-            }
-            
-            // If Discord client not initialized, create it (unless user disconnected)
-            if (discord == nullptr && !userDisconnected) {
-                discord = std::make_unique<DiscordRPC>(discordId);
-                sessionStartTime = DiscordRPC::getCurrentTimestamp();
-                if (debugMode) {
-                    std::cout << "Initialized Discord RPC client" << std::endl;
-                }
-            }
-            
-            // If we are already connected
-            if (discord && discord->isConnected()) {
-                // Get FL Studio data and update activity
-                FLStudioData data = FLParser::getData(stateFile);
-                
-                
-                DiscordActivity activity;
-                activity.state = std::to_string(data.bpm) + " BPM";
-                activity.details = data.state;
-                if (!data.plugin.empty()) {
-                    activity.details += " • " + data.plugin;
-                }
-                std::string lowerState = data.state;
-                std::transform(lowerState.begin(), lowerState.end(), lowerState.begin(), ::tolower);
-                activity.smallImage = lowerState;
-                activity.largeImage = "fl_studio_logo";
-                activity.largeText = "FL Studio";
-                activity.startTime = sessionStartTime;
-                
-                
-                if (discord->updateActivity(activity)) {
-                    if (debugMode) {
-                        std::cout << "✅ Rich Presence updated: " << data.state << " @ " << data.bpm << " BPM";
-                        if (!data.plugin.empty()) {
-                            std::cout << " (" << data.plugin << ")";
-                        }
-                        std::cout << std::endl;
-                    }
-                } else {
-                    if (debugMode) {
-                    std::cout << "❌ Failed to update Rich Presence" << std::endl;
-                }
-                }
-                
-            } else if (discord && !userDisconnected) {
-                // Try to connect (only if user hasn't manually disconnected)
-                if (discord->connect()) {
-                    if (debugMode) {
-                        std::cout << "✅ Connected to Discord!" << std::endl;
-                    }
-                    
-                    // Set initial activity
-                    DiscordActivity activity;
-                    activity.state = "Starting up...";
-                    activity.details = "FL Studio";
-                    activity.largeImage = "fl_studio_logo";
-                    activity.largeText = "FL Studio";
-                    activity.smallImage = "idle";
-                    activity.startTime = sessionStartTime;
-                    
-                    discord->updateActivity(activity);
-                } else {
-                    if (debugMode) {
-                        std::cout << "❌ Failed to connect to Discord. Is Discord running?" << std::endl;
-                    }
-                }
-            }
-            
-        } else {
-            // FL Studio not running - disconnect if connected
-            if (discord != nullptr && discord->isConnected()) {
-                if (debugMode) {
-                    std::cout << "FL Studio not running - clearing Discord presence" << std::endl;
-                }
-                discord->clearActivity();
-                discord->disconnect();
-                sessionStartTime = 0; // Reset timer for next session
-            }
-        }
-        
+    app.startMonitoring();
+
+    while (app.update()) {
         // Process tray messages
         tray.processMessages();
-        
+
         // Wait before next check
-        std::this_thread::sleep_for(std::chrono::milliseconds(pollInterval));
+        app.waitForNextTick();
+    }
+
+    finishTracing();
+    return 0;
+}
+
+#else
+
+static volatile std::sig_atomic_t g_stopRequested = 0;
+
+static void handleStopSignal(int) {
+    g_stopRequested = 1;
+}
+
+// Headless build for Linux (FL Studio under Wine): no tray, console output only
+int main() {
+    AppSettings settings;
+    ConfigLoader config;
+    if (!loadSettings(config, settings)) {
+        std::cerr << "Failed to load .env file!" << std::endl;
+        return 1;
+    }
+
+    Logger::start(settings.debugMode ? LogLevel::Debug : LogLevel::Info);
+    if (settings.debugMode) {
+        printSettings(settings);
+    }
+
+    startTracing(settings);
+
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    AppState app;
+    app.initialize(settings);
+
+    // Same requests as the tray menu on Windows, for scripts and headless runs
+    ControlServer control(app);
+    if (!settings.controlSocket.empty() && !control.start(settings.controlSocket)) {
+        LOG_ERROR("Failed to open control socket {}", settings.controlSocket);
+    }
+
+    app.startMonitoring();
+
+    // The update after a stop signal shuts down and ends the loop
+    while (app.update()) {
+        app.waitForNextTick();
+        if (g_stopRequested) {
+            app.requestExit();
+        }
     }
-    
-    // Cleanup - smart pointer automatically handles deallocation
-    discord.reset();
-    
+
+    finishTracing();
     return 0;
-}
\ No newline at end of file
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "memory_stats.h"
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+// Replacement global allocation functions feeding MemoryStats. Built into
+// FLRP only with -DFLRP_MEMORY_STATS=ON: every allocation pays for the
+// usable-size lookup and the counter updates.
+
+namespace {
+
+size_t usableSize(void* p) {
+#if defined(_WIN32)
+    return _msize(p);
+#elif defined(__linux__)
+    return malloc_usable_size(p);
+#else
+    return 0;
+#endif
+}
+
+void* countedAlloc(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) return nullptr;
+    MemoryStats::recordAllocation(size, usableSize(p));
+    return p;
+}
+
+void countedFree(void* p) {
+    if (!p) return;
+    MemoryStats::recordFree(usableSize(p));
+    std::free(p);
+}
+
+struct HookRegistration {
+    HookRegistration() { MemoryStats::markHookInstalled(); }
+} g_registration;
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = countedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
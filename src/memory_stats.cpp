@@ -0,0 +1,226 @@
+#include "memory_stats.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t SUBSYSTEM_COUNT = static_cast<size_t>(MemoryStats::Subsystem::Count);
+
+// Plain globals with constant initialization so they are usable from
+// operator new (memory_hook.cpp) before any static constructor has run
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_frees{0};
+std::atomic<uint64_t> g_bytesAllocated{0};
+std::atomic<int64_t> g_liveBytes{0};
+std::atomic<uint64_t> g_subsystemAllocations[SUBSYSTEM_COUNT];
+std::atomic<uint64_t> g_subsystemBytes[SUBSYSTEM_COUNT];
+
+std::atomic<bool> g_hookInstalled{false};
+
+thread_local MemoryStats::Subsystem t_subsystem = MemoryStats::Subsystem::Other;
+thread_local uint64_t t_allocations = 0;
+
+#ifndef _WIN32
+// Reads a "Key:   1234 kB" line from /proc/self/status without touching the heap
+size_t readStatusKb(const char* key) {
+    int fd = open("/proc/self/status", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+
+    char buffer[4096];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buffer[n] = '\0';
+
+    const char* line = std::strstr(buffer, key);
+    if (!line) return 0;
+    line += std::strlen(key);
+    while (*line == ' ' || *line == '\t') line++;
+
+    size_t kb = 0;
+    while (*line >= '0' && *line <= '9') {
+        kb = kb * 10 + static_cast<size_t>(*line++ - '0');
+    }
+    return kb;
+}
+#endif
+
+std::string formatKb(size_t bytes) {
+    return std::to_string(bytes / 1024) + " KB";
+}
+
+} // namespace
+
+MemoryStats::HeapCounters MemoryStats::heap() {
+    HeapCounters counters;
+    counters.allocations = g_allocations.load(std::memory_order_relaxed);
+    counters.frees = g_frees.load(std::memory_order_relaxed);
+    counters.bytesAllocated = g_bytesAllocated.load(std::memory_order_relaxed);
+    counters.liveBytes = g_liveBytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+MemoryStats::SubsystemCounters MemoryStats::subsystem(Subsystem which) {
+    size_t slot = static_cast<size_t>(which);
+    SubsystemCounters counters;
+    counters.allocations = g_subsystemAllocations[slot].load(std::memory_order_relaxed);
+    counters.bytesAllocated = g_subsystemBytes[slot].load(std::memory_order_relaxed);
+    return counters;
+}
+
+const char* MemoryStats::subsystemName(Subsystem which) {
+    switch (which) {
+        case Subsystem::Other:    return "other";
+        case Subsystem::Monitor:  return "monitor";
+        case Subsystem::Parser:   return "parser";
+        case Subsystem::Discord:  return "discord";
+        case Subsystem::Presence: return "presence";
+        default:                  return "unknown";
+    }
+}
+
+MemoryStats::Subsystem MemoryStats::currentSubsystem() {
+    return t_subsystem;
+}
+
+void MemoryStats::setCurrentSubsystem(Subsystem which) {
+    t_subsystem = which;
+}
+
+uint64_t MemoryStats::threadAllocations() {
+    return t_allocations;
+}
+
+bool MemoryStats::hookInstalled() {
+    return g_hookInstalled.load(std::memory_order_relaxed);
+}
+
+void MemoryStats::recordAllocation(size_t size, size_t usableBytes) {
+    size_t slot = static_cast<size_t>(t_subsystem);
+    t_allocations++;
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    g_liveBytes.fetch_add(static_cast<int64_t>(usableBytes), std::memory_order_relaxed);
+    g_subsystemAllocations[slot].fetch_add(1, std::memory_order_relaxed);
+    g_subsystemBytes[slot].fetch_add(size, std::memory_order_relaxed);
+}
+
+void MemoryStats::recordFree(size_t usableBytes) {
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    g_liveBytes.fetch_sub(static_cast<int64_t>(usableBytes), std::memory_order_relaxed);
+}
+
+void MemoryStats::markHookInstalled() {
+    g_hookInstalled.store(true, std::memory_order_relaxed);
+}
+
+size_t MemoryStats::currentRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return pmc.WorkingSetSize;
+    }
+    return 0;
+#else
+    return readStatusKb("VmRSS:") * 1024;
+#endif
+}
+
+size_t MemoryStats::peakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return pmc.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    return readStatusKb("VmHWM:") * 1024;
+#endif
+}
+
+MemoryScope::MemoryScope(MemoryStats::Subsystem which)
+    : m_previous(MemoryStats::currentSubsystem()) {
+    MemoryStats::setCurrentSubsystem(which);
+}
+
+MemoryScope::~MemoryScope() {
+    MemoryStats::setCurrentSubsystem(m_previous);
+}
+
+MemoryTracker::MemoryTracker()
+    : m_ticks(0)
+    , m_tickStartAllocations(0)
+    , m_lastTickAllocations(0)
+    , m_maxTickAllocations(0)
+    , m_steadyStateAllocations(0)
+    , m_steadyStateAllocatingTicks(0)
+    , m_steadyRssStart(0)
+    , m_steadyRssMax(0) {
+}
+
+void MemoryTracker::beginTick() {
+    m_tickStartAllocations = MemoryStats::threadAllocations();
+}
+
+uint64_t MemoryTracker::endTick() {
+    uint64_t allocations = MemoryStats::threadAllocations() - m_tickStartAllocations;
+    m_ticks++;
+    m_lastTickAllocations = allocations;
+    if (allocations > m_maxTickAllocations) {
+        m_maxTickAllocations = allocations;
+    }
+
+    if (inSteadyState()) {
+        size_t rss = MemoryStats::currentRss();
+        if (m_steadyRssStart == 0) {
+            m_steadyRssStart = rss;
+        }
+        if (rss > m_steadyRssMax) {
+            m_steadyRssMax = rss;
+        }
+        if (allocations > 0) {
+            m_steadyStateAllocations += allocations;
+            m_steadyStateAllocatingTicks++;
+        }
+    }
+
+    return allocations;
+}
+
+std::string MemoryTracker::report() const {
+    MemoryStats::HeapCounters heap = MemoryStats::heap();
+
+    std::string out = "Memory after " + std::to_string(m_ticks) + " ticks:\n";
+    out += "  RSS: " + formatKb(MemoryStats::currentRss()) +
+           " (peak " + formatKb(MemoryStats::peakRss()) + ")\n";
+    if (inSteadyState()) {
+        out += "  Steady-state RSS: " + formatKb(m_steadyRssStart) +
+               " at start, " + formatKb(m_steadyRssMax) + " max\n";
+    }
+    out += "  Heap: " + std::to_string(heap.allocations) + " allocs, " +
+           std::to_string(heap.frees) + " frees, " +
+           formatKb(heap.liveBytes > 0 ? static_cast<size_t>(heap.liveBytes) : 0) + " live\n";
+    out += "  Allocs/tick: last " + std::to_string(m_lastTickAllocations) +
+           ", max " + std::to_string(m_maxTickAllocations) +
+           ", steady-state " + std::to_string(m_steadyStateAllocations) +
+           " in " + std::to_string(m_steadyStateAllocatingTicks) + " ticks\n";
+
+    out += "  By subsystem:";
+    for (size_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+        MemoryStats::Subsystem which = static_cast<MemoryStats::Subsystem>(i);
+        MemoryStats::SubsystemCounters counters = MemoryStats::subsystem(which);
+        out += std::string(" ") + MemoryStats::subsystemName(which) + "=" +
+               std::to_string(counters.allocations) + "/" + formatKb(counters.bytesAllocated);
+    }
+    out += "\n";
+    return out;
+}
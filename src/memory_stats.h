@@ -0,0 +1,127 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Process-wide memory accounting
+ *
+ * Heap allocations are counted by the replacement global operator new/delete
+ * in memory_hook.cpp, which is only linked in with -DFLRP_MEMORY_STATS=ON.
+ * Each allocation is attributed to the subsystem active on the calling
+ * thread (see MemoryScope) and to the calling thread itself. Resident set
+ * size is sampled from the OS.
+ */
+class MemoryStats {
+    public:
+        enum class Subsystem {
+            Other,
+            Monitor,
+            Parser,
+            Discord,
+            Presence,
+            Count
+        };
+
+        struct HeapCounters {
+            uint64_t allocations;
+            uint64_t frees;
+            uint64_t bytesAllocated;
+            int64_t liveBytes;
+        };
+
+        struct SubsystemCounters {
+            uint64_t allocations;
+            uint64_t bytesAllocated;
+        };
+
+        static HeapCounters heap();
+        static SubsystemCounters subsystem(Subsystem which);
+        static const char* subsystemName(Subsystem which);
+
+        static Subsystem currentSubsystem();
+        static void setCurrentSubsystem(Subsystem which);
+
+        /**
+         * @brief Heap allocations made so far by the calling thread
+         */
+        static uint64_t threadAllocations();
+
+        /**
+         * @brief Whether memory_hook.cpp is linked in; without it every counter stays 0
+         */
+        static bool hookInstalled();
+
+        // Called by the allocation hook
+        static void recordAllocation(size_t size, size_t usableBytes);
+        static void recordFree(size_t usableBytes);
+        static void markHookInstalled();
+
+        /**
+         * @brief Current resident set size in bytes, 0 if unavailable
+         */
+        static size_t currentRss();
+
+        /**
+         * @brief Peak resident set size in bytes, 0 if unavailable
+         */
+        static size_t peakRss();
+};
+
+/**
+ * @brief Attributes allocations on this thread to a subsystem for its lifetime
+ */
+class MemoryScope {
+    private:
+        MemoryStats::Subsystem m_previous;
+
+    public:
+        explicit MemoryScope(MemoryStats::Subsystem which);
+        ~MemoryScope();
+
+        MemoryScope(const MemoryScope&) = delete;
+        MemoryScope& operator=(const MemoryScope&) = delete;
+};
+
+/**
+ * @brief Per-iteration allocation and RSS tracking for the main loop
+ *
+ * Only allocations made on the thread calling beginTick()/endTick() count;
+ * the sensor, control and logger threads allocate on their own schedule.
+ * The first few ticks are treated as warm-up (connection setup, buffer
+ * growth); after that the loop is expected not to allocate at all and any
+ * allocation is counted as a steady-state violation.
+ */
+class MemoryTracker {
+    private:
+        static const uint64_t WARMUP_TICKS = 10;
+
+        uint64_t m_ticks;
+        uint64_t m_tickStartAllocations;
+        uint64_t m_lastTickAllocations;
+        uint64_t m_maxTickAllocations;
+        uint64_t m_steadyStateAllocations;
+        uint64_t m_steadyStateAllocatingTicks;
+        size_t m_steadyRssStart;
+        size_t m_steadyRssMax;
+
+    public:
+        MemoryTracker();
+
+        void beginTick();
+
+        /**
+         * @brief Close the current tick
+         * @return Number of heap allocations the calling thread made during the tick
+         */
+        uint64_t endTick();
+
+        uint64_t ticks() const { return m_ticks; }
+        uint64_t steadyStateAllocations() const { return m_steadyStateAllocations; }
+        bool inSteadyState() const { return m_ticks > WARMUP_TICKS; }
+
+        /**
+         * @brief Multi-line report of RSS, heap and per-subsystem usage
+         */
+        std::string report() const;
+};
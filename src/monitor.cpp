@@ -1,19 +1,23 @@
 #include "monitor.h"
-#include <iostream>
-#include <algorithm>
-#include <string>
+#include "logger.h"
 
-#ifdef _WIN32
+#ifndef _WIN32
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-void ProcessMonitor::setDebugMode(bool debug) {
-    debugMode = debug;
-}
+#ifdef _WIN32
 
 bool ProcessMonitor::searchForFLStudio() {
+    m_pid = 0;
+    
     // Create snapshot of all processes
     HANDLE hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
     if (hProcessSnap == INVALID_HANDLE_VALUE) {
-        std::cerr << "❌ CreateToolhelp32Snapshot failed" << std::endl;
+        LOG_ERROR("❌ CreateToolhelp32Snapshot failed");
         return false;
     }
     
@@ -22,45 +26,28 @@ bool ProcessMonitor::searchForFLStudio() {
     
     // Get the first process
     if (!Process32First(hProcessSnap, &pe32)) {
-        std::cerr << "❌ Process32First failed" << std::endl;
+        LOG_ERROR("❌ Process32First failed");
         CloseHandle(hProcessSnap);
         return false;
     }
     
     // Walk through processes until we find FL Studio
     do {
-        // Convert wide character string to regular string
-        std::string processName;
+        // Convert wide character string to a stack buffer
+        char nameBuffer[MAX_PATH * 3];
         
 #ifdef UNICODE
-        // Convert from WCHAR to std::string
-        int size = WideCharToMultiByte(CP_UTF8, 0, pe32.szExeFile, -1, NULL, 0, NULL, NULL);
-        if (size > 0) {
-            processName.resize(size - 1);
-            WideCharToMultiByte(CP_UTF8, 0, pe32.szExeFile, -1, &processName[0], size, NULL, NULL);
-        }
+        int size = WideCharToMultiByte(CP_UTF8, 0, pe32.szExeFile, -1, nameBuffer, sizeof(nameBuffer), NULL, NULL);
+        std::string_view processName(nameBuffer, size > 0 ? static_cast<size_t>(size - 1) : 0);
 #else
         // For non-Unicode builds (rare)
-        processName = pe32.szExeFile;
+        std::string_view processName(pe32.szExeFile);
 #endif
         
-        // Convert to lowercase for comparison
-        std::transform(processName.begin(), processName.end(), processName.begin(), ::tolower);
-        
         // Check for FL Studio processes (removed early exit optimization)
-        if (processName == "fl64.exe" || 
-            processName == "fl64" ||        // Sometimes shows without .exe
-            processName == "fl32.exe" || 
-            processName == "fl32" ||
-            processName == "fl.exe" ||
-            processName == "fl" ||
-            processName == "flstudio.exe" ||
-            processName == "flstudio" ||
-            (processName.find("fl") == 0 && processName.find("studio") != std::string::npos)) {
-            
-            if (debugMode) {
-                std::cout << "🎵 Found FL Studio process: " << processName << std::endl;
-            }
+        if (m_matcher.matches(processName)) {
+            LOG_DEBUG("🎵 Found FL Studio process: {}", processName);
+            m_pid = pe32.th32ProcessID;
             CloseHandle(hProcessSnap);
             return true;
         }
@@ -72,9 +59,50 @@ bool ProcessMonitor::searchForFLStudio() {
 }
 
 #else
-// Non-Windows implementation (placeholder)
+// Linux/Wine: FL Studio shows up with its Windows executable name in /proc/<pid>/comm
 bool ProcessMonitor::searchForFLStudio() {
-    std::cerr << "❌ Process monitoring not implemented for this platform" << std::endl;
-    return false;
+    m_pid = 0;
+    DIR* proc = opendir("/proc");
+    if (!proc) {
+        LOG_ERROR("❌ Cannot open /proc");
+        return false;
+    }
+    
+    bool found = false;
+    struct dirent* entry;
+    while (!found && (entry = readdir(proc)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        
+        // Formatted from the number so the path always fits
+        unsigned long pid = std::strtoul(entry->d_name, nullptr, 10);
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%lu/comm", pid);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        
+        char name[64];
+        ssize_t n = read(fd, name, sizeof(name) - 1);
+        close(fd);
+        if (n <= 0) {
+            continue;
+        }
+        if (name[n - 1] == '\n') {
+            n--;
+        }
+        
+        std::string_view processName(name, static_cast<size_t>(n));
+        if (m_matcher.matches(processName)) {
+            LOG_DEBUG("🎵 Found FL Studio process: {}", processName);
+            m_pid = static_cast<uint32_t>(pid);
+            found = true;
+        }
+    }
+    
+    closedir(proc);
+    return found;
 }
-#endif
\ No newline at end of file
+#endif
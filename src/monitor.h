@@ -1,12 +1,23 @@
 #pragma once
+#include <cstdint>
+#include <string_view>
+#include "process_matcher.h"
+
+#ifdef _WIN32
 #include <windows.h>
 #include <tlhelp32.h>
+#endif
 
 class ProcessMonitor {
     private:
-        bool debugMode = false;
+        ProcessMatcher m_matcher;
+        uint32_t m_pid;         // Of the FL Studio process the last search found, 0 if none
         
     public:
-        void setDebugMode(bool debug);
+        ProcessMonitor() : m_pid(0) {}
+        
+        void setMatcher(const ProcessMatcher& matcher) { m_matcher = matcher; }
+        
         bool searchForFLStudio();
-};
\ No newline at end of file
+        uint32_t pid() const { return m_pid; }
+};
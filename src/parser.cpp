@@ -1,38 +1,119 @@
 #include "parser.h"
-#include <fstream>
-#include <iostream>
+#include "json_lite.h"
+#include "logger.h"
+#include "trace.h"
 #include <filesystem>
 
-FLStudioData FLParser::getData(const std::string& filePath) {
-    FLStudioData data;
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-    try {
-        if (!std::filesystem::exists(filePath)) {
-            std::cerr << "FL Studio state file not found: " << filePath << std::endl;
-            return data;
-        }
+// Reads the whole file into the arena without going through the heap
+static bool readFile(const std::string& filePath, TickArena& arena, std::string_view& contents) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart > 1024 * 1024) {
+        CloseHandle(file);
+        return false;
+    }
+    
+    char* buffer = arena.allocateChars(static_cast<size_t>(size.QuadPart));
+    DWORD read = 0;
+    BOOL ok = ReadFile(file, buffer, static_cast<DWORD>(size.QuadPart), &read, nullptr);
+    CloseHandle(file);
+    if (!ok) {
+        return false;
+    }
+    contents = std::string_view(buffer, read);
+#else
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size > 1024 * 1024) {
+        close(fd);
+        return false;
+    }
+    
+    char* buffer = arena.allocateChars(static_cast<size_t>(st.st_size));
+    ssize_t n = read(fd, buffer, static_cast<size_t>(st.st_size));
+    close(fd);
+    if (n < 0) {
+        return false;
+    }
+    contents = std::string_view(buffer, static_cast<size_t>(n));
+#endif
+    return true;
+}
 
-        std::ifstream file(filePath);
-        if (!file.is_open()) {
-            std::cerr << "Could not open FL Studio file state: " << filePath << std::endl;
-            return data;
-        }
+FLStudioData FLParser::getData(const std::string& filePath, TickArena& arena) {
+    FLStudioData data;
 
-        nlohmann::json jsonData;
-        file >> jsonData;
+    std::string_view contents;
+    bool read;
+    {
+        TraceScope trace(Tracer::Span::StateFileRead);
+        read = readFile(filePath, arena, contents);
+    }
+    if (!read) {
+        LOG_WARN("Could not open FL Studio file state: {}", filePath);
+        return data;
+    }
 
-        data.state = jsonData.value("state", "Idle");
-        data.bpm = static_cast<int>(jsonData.value("bpm", 130.0));
-        data.plugin = jsonData.value("plugin", "");
-        data.projectName = jsonData.value("project_name", "");
-        data.timestamp = jsonData.value("timestamp", 0);
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing FL Studio state file: " << e.what() << std::endl;
+    bool parsed;
+    {
+        TraceScope trace(Tracer::Span::Parse);
+        parsed = parse(contents.data(), contents.size(), arena, data);
+    }
+    if (!parsed) {
+        LOG_WARN("Error parsing FL Studio state file: {}", filePath);
     }
+    data.loaded = parsed;
 
     return data;
 }
 
+bool FLParser::parse(const char* json, size_t length, TickArena& arena, FLStudioData& data) {
+    FlatJsonReader reader(json, length);
+    std::string_view key;
+    std::string_view text;
+    double number;
+
+    while (reader.nextKey(key)) {
+        if (key == "state") {
+            if (reader.readString(arena, text)) data.state = parsePresenceState(text);
+        } else if (key == "bpm") {
+            // Rounded, so tempo jitter around a whole BPM (127.999/128.001) reads as one value
+            if (reader.readNumber(number)) data.bpm = static_cast<int>(number + 0.5);
+        } else if (key == "plugin") {
+            reader.readString(arena, data.plugin);
+        } else if (key == "project_name") {
+            reader.readString(arena, data.projectName);
+        } else if (key == "timestamp") {
+            if (reader.readNumber(number)) data.timestamp = static_cast<int>(number);
+        } else if (key == "write_time") {
+            // Fractional Unix seconds; older scripts write whole seconds
+            if (reader.readNumber(number) && number > 0) data.writeTimeMs = static_cast<long long>(number * 1000.0 + 0.5);
+        } else {
+            reader.skipValue();
+        }
+    }
+
+    return !reader.failed();
+}
+
 bool FLParser::isFileAvailable(const std::string& filePath) {
     return std::filesystem::exists(filePath);
-}
\ No newline at end of file
+}
@@ -1,19 +1,26 @@
 #pragma once
 #include <string>
-#include "../lib/json.hpp"
+#include <string_view>
+#include "arena.h"
+#include "presence.h"
 
+// String fields point into the TickArena passed to FLParser and are valid
+// until that arena is reset
 struct FLStudioData {
-    std::string state;
+    PresenceState state;
     int bpm;
-    std::string plugin;
-    std::string projectName; 
+    std::string_view plugin;
+    std::string_view projectName; 
     int timestamp;
+    long long writeTimeMs;      // When the script wrote the record (Unix ms), 0 if missing
+    bool loaded;                // The file was read and parsed; the defaults above otherwise
 
-    FLStudioData() : state("Idle"), bpm(130), projectName(""), timestamp(0) {}
+    FLStudioData() : state(PresenceState::Idle), bpm(130), projectName(""), timestamp(0), writeTimeMs(0), loaded(false) {}
 };
 
 class FLParser {
     public:
-        static FLStudioData getData(const std::string& filePath);
+        static FLStudioData getData(const std::string& filePath, TickArena& arena);
+        static bool parse(const char* json, size_t length, TickArena& arena, FLStudioData& data);
         static bool isFileAvailable(const std::string& filePath);
-};
\ No newline at end of file
+};
@@ -0,0 +1,71 @@
+#include "poll_policy.h"
+#include <cstdio>
+
+const char* pollModeName(PollMode mode) {
+    switch (mode) {
+        case PollMode::Absent:      return "absent";
+        case PollMode::DiscordDown: return "discord_down";
+        case PollMode::Idle:        return "idle";
+        case PollMode::Active:      return "active";
+        case PollMode::Recording:   return "recording";
+        case PollMode::Count:       break;
+    }
+    return "unknown";
+}
+
+bool WakeupStats::operator==(const WakeupStats& other) const {
+    for (size_t i = 0; i < MODES; i++) {
+        if (ticks[i] != other.ticks[i] || scans[i] != other.scans[i] || millis[i] != other.millis[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t WakeupStats::perHour(PollMode mode) const {
+    size_t i = static_cast<size_t>(mode);
+    if (millis[i] < 1000) {
+        return 0;
+    }
+    return (ticks[i] + scans[i]) * 3600000 / millis[i];
+}
+
+std::string WakeupStats::summary() const {
+    std::string line;
+    char part[64];
+    for (size_t i = 0; i < MODES; i++) {
+        PollMode mode = static_cast<PollMode>(i);
+        std::snprintf(part, sizeof(part), "%s%s %llu/h", i == 0 ? "" : ", ", pollModeName(mode),
+                      static_cast<unsigned long long>(perHour(mode)));
+        line += part;
+    }
+    return line;
+}
+
+WakeupCounter::WakeupCounter(Clock::TimePoint start)
+    : m_mode(PollMode::Absent)
+    , m_since(start) {
+}
+
+void WakeupCounter::account(Clock::TimePoint now) {
+    if (now <= m_since) {
+        return;
+    }
+    // Whole milliseconds only; the remainder carries over to the next call
+    std::chrono::milliseconds elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_since);
+    m_stats.millis[static_cast<size_t>(m_mode)] += static_cast<uint64_t>(elapsed.count());
+    m_since += elapsed;
+}
+
+void WakeupCounter::setMode(PollMode mode, Clock::TimePoint now) {
+    if (mode == m_mode) {
+        return;
+    }
+    account(now);
+    m_mode = mode;
+}
+
+WakeupStats WakeupCounter::stats(Clock::TimePoint now) {
+    account(now);
+    return m_stats;
+}
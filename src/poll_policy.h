@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "clock.h"
+
+/**
+ * @brief Polling intervals for each situation the loop can be in
+ */
+struct PollPolicy {
+    int idleMs;         // FL Studio open but idle (POLL_INTERVAL_MS)
+    int activeMs;       // Playing, recording or in the piano roll
+    int absentMaxMs;    // Back-off ceiling while FL Studio isn't running
+    int sampleMs;       // Minimum time between FL Studio CPU/memory samples, 0 to disable
+
+    PollPolicy() : idleMs(1000), activeMs(500), absentMaxMs(30000), sampleMs(5000) {}
+};
+
+/**
+ * @brief What the update loop is waiting for, which decides how often it wakes
+ */
+enum class PollMode : uint8_t {
+    Absent,         // No FL Studio: scans back off, the update loop sleeps until it appears
+    DiscordDown,    // No Discord connection: woken by connect retries or a new endpoint
+    Idle,           // Session open, nothing happening
+    Active,         // Session in use: tighter interval
+    Recording,      // Audio-safe mode: idle interval, non-essential work deferred
+    Count
+};
+
+const char* pollModeName(PollMode mode);
+
+/**
+ * @brief Update loop wakeups and sensor scans per poll mode, for wakeups/hour
+ */
+struct WakeupStats {
+    static const size_t MODES = static_cast<size_t>(PollMode::Count);
+
+    uint64_t ticks[MODES];          // Update loop wakeups
+    uint64_t scans[MODES];          // Sensor thread scans
+    uint64_t millis[MODES];         // Time spent in the mode
+
+    WakeupStats() : ticks(), scans(), millis() {}
+
+    bool operator==(const WakeupStats& other) const;
+    bool operator!=(const WakeupStats& other) const { return !(*this == other); }
+
+    /**
+     * @brief Wakeups (ticks plus scans) per hour spent in the mode, 0 before a second has passed
+     */
+    uint64_t perHour(PollMode mode) const;
+
+    /**
+     * @brief One line: "absent 120/h, discord_down 0/h, idle 3600/h, active 7200/h, recording 3600/h"
+     */
+    std::string summary() const;
+};
+
+/**
+ * @brief Tracks the current poll mode and counts wakeups against it (update thread only)
+ */
+class WakeupCounter {
+    private:
+        WakeupStats m_stats;
+        PollMode m_mode;
+        Clock::TimePoint m_since;      // When the time in m_mode was last accounted
+
+        void account(Clock::TimePoint now);
+
+    public:
+        explicit WakeupCounter(Clock::TimePoint start);
+
+        PollMode mode() const { return m_mode; }
+        void setMode(PollMode mode, Clock::TimePoint now);
+
+        void countTick() { m_stats.ticks[static_cast<size_t>(m_mode)]++; }
+        void countScans(uint64_t scans) { m_stats.scans[static_cast<size_t>(m_mode)] += scans; }
+
+        /**
+         * @brief Counts so far, with the time in the current mode up to now
+         */
+        WakeupStats stats(Clock::TimePoint now);
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @brief FL Studio activity states, as written by the FLRP script
+ */
+enum class PresenceState : uint8_t {
+    Starting,   // Connected, no state read yet
+    Idle,
+    Recording,
+    Listening,
+    Composing
+};
+
+// Interned presence text. Asset keys must match the Discord application's art assets.
+namespace presence_text {
+    constexpr std::string_view LARGE_IMAGE = "fl_studio_logo";
+    constexpr std::string_view LARGE_TEXT = "FL Studio";
+    constexpr std::string_view STARTING_STATE = "Starting up...";
+    constexpr std::string_view STARTING_DETAILS = "FL Studio";
+    constexpr std::string_view DETAILS_TEMPLATE = "{state}[ • {plugin}]";
+    constexpr std::string_view STATE_TEMPLATE = "{bpm} BPM";
+}
+
+/**
+ * @brief Display name of a state ("Recording")
+ */
+constexpr std::string_view presenceStateName(PresenceState state) {
+    switch (state) {
+        case PresenceState::Starting:  return "Starting";
+        case PresenceState::Recording: return "Recording";
+        case PresenceState::Listening: return "Listening";
+        case PresenceState::Composing: return "Composing";
+        default:                       return "Idle";
+    }
+}
+
+/**
+ * @brief Small image asset key of a state ("recording")
+ */
+constexpr std::string_view presenceStateAsset(PresenceState state) {
+    switch (state) {
+        case PresenceState::Recording: return "recording";
+        case PresenceState::Listening: return "listening";
+        case PresenceState::Composing: return "composing";
+        default:                       return "idle";
+    }
+}
+
+/**
+ * @brief Map a state name from the state file to its enum, Idle if unknown
+ */
+inline PresenceState parsePresenceState(std::string_view name) {
+    if (name == "Recording") return PresenceState::Recording;
+    if (name == "Listening") return PresenceState::Listening;
+    if (name == "Composing") return PresenceState::Composing;
+    return PresenceState::Idle;
+}
+
+/**
+ * @brief Fixed-capacity string stored inline
+ *
+ * Longer text is truncated at a UTF-8 character boundary. Discord caps
+ * activity strings at 128 characters, which bounds what is worth keeping.
+ */
+template <size_t N>
+class InlineString {
+    static_assert(N > 0 && N < 256, "InlineString length is stored in one byte");
+
+    private:
+        uint8_t m_size;
+        char m_data[N];
+
+    public:
+        InlineString() : m_size(0) {}
+        InlineString(std::string_view text) { assign(text); }
+
+        void assign(std::string_view text) {
+            size_t size = text.size();
+            if (size > N) {
+                size = N;
+                // Don't split a multi-byte character
+                while (size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) {
+                    size--;
+                }
+            }
+            std::memcpy(m_data, text.data(), size);
+            m_size = static_cast<uint8_t>(size);
+        }
+
+        void clear() { m_size = 0; }
+        bool empty() const { return m_size == 0; }
+        size_t size() const { return m_size; }
+        std::string_view view() const { return std::string_view(m_data, m_size); }
+
+        bool operator==(const InlineString& other) const { return view() == other.view(); }
+        bool operator!=(const InlineString& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief FNV-1a, used to hash presence fields
+ */
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
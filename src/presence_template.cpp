@@ -0,0 +1,189 @@
+#include "presence_template.h"
+#include "json_lite.h"
+#include <charconv>
+#include <iterator>
+
+namespace {
+
+// Field names as written between braces, indexed by PresenceTemplate::Field
+const std::string_view FIELD_NAMES[] = { "state", "bpm", "plugin", "project", "cpu", "memory" };
+
+// Longest prefix of text that fits in budget bytes without splitting a character
+std::string_view cutToBudget(std::string_view text, size_t budget) {
+    if (text.size() <= budget) {
+        return text;
+    }
+    size_t size = budget;
+    while (size > 0 && (static_cast<unsigned char>(text[size]) & 0xC0) == 0x80) {
+        size--;
+    }
+    return text.substr(0, size);
+}
+
+} // namespace
+
+bool PresenceTemplate::compile(std::string_view source, std::string& error) {
+    if (source.size() > MAX_SOURCE) {
+        error = "template longer than " + std::to_string(MAX_SOURCE) + " bytes";
+        return false;
+    }
+
+    std::vector<Instruction> program;
+    std::string literals;
+    std::string pending;            // Literal text not yet emitted
+    std::vector<size_t> sections;   // Indices of the open Section instructions
+    uint8_t used = 0;
+
+    auto flushLiteral = [&]() {
+        if (pending.empty()) {
+            return;
+        }
+        size_t offset = literals.size();
+        appendJsonEscaped(literals, pending);
+        program.push_back({ Op::Literal, 0, static_cast<uint16_t>(offset),
+                            static_cast<uint16_t>(literals.size() - offset),
+                            static_cast<uint16_t>(pending.size()) });
+        pending.clear();
+    };
+
+    for (size_t i = 0; i < source.size(); i++) {
+        char c = source[i];
+        switch (c) {
+            case '\\':
+                if (i + 1 == source.size()) {
+                    error = "trailing backslash";
+                    return false;
+                }
+                pending += source[++i];
+                break;
+            case '{': {
+                size_t close = source.find('}', i + 1);
+                if (close == std::string_view::npos) {
+                    error = "unclosed { at offset " + std::to_string(i);
+                    return false;
+                }
+                std::string_view name = source.substr(i + 1, close - i - 1);
+                size_t field = 0;
+                while (field < std::size(FIELD_NAMES) && FIELD_NAMES[field] != name) {
+                    field++;
+                }
+                if (field == std::size(FIELD_NAMES)) {
+                    error = "unknown field {" + std::string(name) + "}";
+                    return false;
+                }
+                flushLiteral();
+                program.push_back({ Op::Field, static_cast<uint8_t>(field), 0, 0, 0 });
+                used |= static_cast<uint8_t>(1u << field);
+                if (!sections.empty()) {
+                    program[sections.back()].arg |= static_cast<uint8_t>(1u << field);
+                }
+                i = close;
+                break;
+            }
+            case '}':
+                error = "unmatched } at offset " + std::to_string(i);
+                return false;
+            case '[':
+                flushLiteral();
+                sections.push_back(program.size());
+                program.push_back({ Op::Section, 0, 0, 0, 0 });
+                break;
+            case ']':
+                if (sections.empty()) {
+                    error = "unmatched ] at offset " + std::to_string(i);
+                    return false;
+                }
+                flushLiteral();
+                program[sections.back()].offset = static_cast<uint16_t>(program.size());
+                sections.pop_back();
+                break;
+            default:
+                pending += c;
+        }
+    }
+    if (!sections.empty()) {
+        error = "unclosed [";
+        return false;
+    }
+    flushLiteral();
+
+    m_program = std::move(program);
+    m_literals = std::move(literals);
+    m_source = std::string(source);
+    m_fields = used;
+    return true;
+}
+
+bool PresenceTemplate::showsUsage() const {
+    return (m_fields & ((1u << static_cast<unsigned>(Field::Cpu)) | (1u << static_cast<unsigned>(Field::Memory)))) != 0;
+}
+
+size_t PresenceTemplate::appendField(Field field, const PresenceFields& fields, size_t budget, ArenaWriter& out) {
+    switch (field) {
+        case Field::State: {
+            std::string_view name = cutToBudget(presenceStateName(fields.state), budget);
+            out += name;
+            return name.size();
+        }
+        case Field::Bpm:
+        case Field::Cpu:
+        case Field::Memory: {
+            int value = field == Field::Bpm ? fields.bpm : field == Field::Cpu ? fields.cpuPercent : fields.memoryMb;
+            char digits[16];
+            std::to_chars_result end = std::to_chars(digits, digits + sizeof(digits), value);
+            size_t size = static_cast<size_t>(end.ptr - digits);
+            // Half a number is worse than none
+            if (size > budget) {
+                return 0;
+            }
+            out += std::string_view(digits, size);
+            return size;
+        }
+        case Field::Plugin:
+        case Field::Project: {
+            std::string_view text = cutToBudget(field == Field::Plugin ? fields.plugin : fields.project, budget);
+            appendJsonEscaped(out, text);
+            return text.size();
+        }
+    }
+    return 0;
+}
+
+size_t PresenceTemplate::render(const PresenceFields& fields, ArenaWriter& out) const {
+    uint8_t empty = 0;
+    if (fields.bpm <= 0) empty |= 1u << static_cast<unsigned>(Field::Bpm);
+    if (fields.plugin.empty()) empty |= 1u << static_cast<unsigned>(Field::Plugin);
+    if (fields.project.empty()) empty |= 1u << static_cast<unsigned>(Field::Project);
+    if (fields.cpuPercent < 0) empty |= 1u << static_cast<unsigned>(Field::Cpu);
+    if (fields.memoryMb <= 0) empty |= 1u << static_cast<unsigned>(Field::Memory);
+
+    size_t written = 0;
+    size_t i = 0;
+    while (i < m_program.size()) {
+        const Instruction& instruction = m_program[i];
+        switch (instruction.op) {
+            case Op::Literal:
+                if (instruction.rawLength > MAX_TEXT - written) {
+                    return written;
+                }
+                out += std::string_view(m_literals.data() + instruction.offset, instruction.length);
+                written += instruction.rawLength;
+                i++;
+                break;
+            case Op::Field:
+                written += appendField(static_cast<Field>(instruction.arg), fields, MAX_TEXT - written, out);
+                i++;
+                break;
+            case Op::Section:
+                i = (instruction.arg & empty) ? instruction.offset : i + 1;
+                break;
+        }
+    }
+    return written;
+}
+
+PresenceFormat::PresenceFormat() {
+    std::string error;
+    details.compile(presence_text::DETAILS_TEMPLATE, error);
+    state.compile(presence_text::STATE_TEMPLATE, error);
+}
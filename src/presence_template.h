@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "presence.h"
+
+/**
+ * @brief Values a presence template can refer to, as views into the activity
+ */
+struct PresenceFields {
+    PresenceState state;
+    int bpm;                        // 0 counts as empty
+    std::string_view plugin;
+    std::string_view project;
+    int cpuPercent;                 // FL Studio's, -1 counts as empty
+    int memoryMb;                   // 0 counts as empty
+};
+
+/**
+ * @brief User-defined activity text, compiled once into a flat instruction list
+ *
+ * {state}, {bpm}, {plugin}, {project}, {cpu} (percent) and {memory} (MB)
+ * insert a field. [ ... ] is a
+ * section, left out when a field directly inside it is empty; sections
+ * nest. \{ \} \[ \] and \\ are literal characters. For example
+ * "{state}[ • {plugin}]" renders "Composing • Serum", or "Composing" with
+ * no plugin focused.
+ *
+ * render() writes into the outgoing frame with no intermediate strings:
+ * literals were JSON-escaped by compile(), so only plugin and project
+ * names are escaped per render. The text is capped at MAX_TEXT bytes;
+ * fields are cut at a character boundary and literals that no longer fit
+ * end the text.
+ */
+class PresenceTemplate {
+    public:
+        static const size_t MAX_TEXT = 128;     // Discord's limit for activity strings
+        static const size_t MAX_SOURCE = 512;
+
+    private:
+        enum class Op : uint8_t {
+            Literal,
+            Field,
+            Section
+        };
+
+        enum class Field : uint8_t {
+            State,
+            Bpm,
+            Plugin,
+            Project,
+            Cpu,
+            Memory
+        };
+
+        struct Instruction {
+            Op op;
+            uint8_t arg;            // Field: which one; Section: bit per Field it requires
+            uint16_t offset;        // Literal: start in m_literals; Section: instruction after its end
+            uint16_t length;        // Literal: escaped length
+            uint16_t rawLength;     // Literal: length before escaping, charged against MAX_TEXT
+        };
+
+        std::vector<Instruction> m_program;
+        std::string m_literals;     // Escaped literal text
+        std::string m_source;
+        uint8_t m_fields;           // Bit per Field the template uses
+
+        static size_t appendField(Field field, const PresenceFields& fields, size_t budget, ArenaWriter& out);
+
+    public:
+        PresenceTemplate() : m_fields(0) {}
+
+        /**
+         * @brief Compile a template, replacing the current one only on success
+         * @param error Receives what is wrong with the source on failure
+         * @return false if the source doesn't parse
+         */
+        bool compile(std::string_view source, std::string& error);
+
+        /**
+         * @brief Append the text, JSON-escaped, to out
+         * @return Length of the text before escaping
+         */
+        size_t render(const PresenceFields& fields, ArenaWriter& out) const;
+
+        const std::string& source() const { return m_source; }
+
+        /**
+         * @brief Whether the text shows FL Studio's CPU or memory use
+         */
+        bool showsUsage() const;
+};
+
+/**
+ * @brief The two lines of activity text Discord shows under the game name
+ */
+struct PresenceFormat {
+    PresenceTemplate details;       // First line: "Composing • Serum"
+    PresenceTemplate state;         // Second line: "128 BPM"
+
+    /**
+     * @brief Compiles the default templates
+     */
+    PresenceFormat();
+
+    bool showsUsage() const { return details.showsUsage() || state.showsUsage(); }
+};
@@ -0,0 +1,181 @@
+#include "process_matcher.h"
+#include <algorithm>
+#include <map>
+
+namespace {
+
+const int STAR = -1;
+
+char foldCase(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Pattern split into literal bytes (case folded) and STAR tokens
+typedef std::vector<int> Tokens;
+
+// NFA over every pattern at once: position j of pattern p is state base[p] + j,
+// meaning the first j tokens have been matched
+struct Nfa {
+    std::vector<Tokens> patterns;
+    std::vector<uint32_t> base;
+    std::vector<uint32_t> owner;        // Pattern of each state
+
+    void build() {
+        uint32_t next = 0;
+        for (size_t p = 0; p < patterns.size(); p++) {
+            base.push_back(next);
+            for (size_t j = 0; j <= patterns[p].size(); j++) {
+                owner.push_back(static_cast<uint32_t>(p));
+            }
+            next += static_cast<uint32_t>(patterns[p].size() + 1);
+        }
+    }
+
+    size_t position(uint32_t state) const { return state - base[owner[state]]; }
+    const Tokens& tokens(uint32_t state) const { return patterns[owner[state]]; }
+
+    // A star can match nothing, so the position after it is reachable too
+    void close(std::vector<uint32_t>& states) const {
+        for (size_t i = 0; i < states.size(); i++) {
+            uint32_t state = states[i];
+            size_t j = position(state);
+            if (j < tokens(state).size() && tokens(state)[j] == STAR) {
+                states.push_back(state + 1);
+            }
+        }
+        std::sort(states.begin(), states.end());
+        states.erase(std::unique(states.begin(), states.end()), states.end());
+    }
+
+    // byte is -1 for the class of bytes no pattern mentions
+    std::vector<uint32_t> step(const std::vector<uint32_t>& states, int byte) const {
+        std::vector<uint32_t> result;
+        for (uint32_t state : states) {
+            size_t j = position(state);
+            if (j == tokens(state).size()) {
+                continue;
+            }
+            int token = tokens(state)[j];
+            if (token == STAR) {
+                result.push_back(state);
+            } else if (token == byte) {
+                result.push_back(state + 1);
+            }
+        }
+        close(result);
+        return result;
+    }
+
+    bool accepts(const std::vector<uint32_t>& states) const {
+        for (uint32_t state : states) {
+            if (position(state) == tokens(state).size()) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+ProcessMatcher::ProcessMatcher() {
+    std::string error;
+    compile(DEFAULT_PATTERNS, error);
+}
+
+bool ProcessMatcher::compile(std::string_view patterns, std::string& error) {
+    Nfa nfa;
+    size_t start = 0;
+    while (start <= patterns.size()) {
+        size_t end = std::min(patterns.find(',', start), patterns.size());
+        std::string_view pattern = patterns.substr(start, end - start);
+        start = end + 1;
+
+        size_t first = pattern.find_first_not_of(" \t");
+        if (first == std::string_view::npos) {
+            continue;
+        }
+        pattern = pattern.substr(first, pattern.find_last_not_of(" \t") - first + 1);
+
+        Tokens tokens;
+        for (char c : pattern) {
+            // Runs of stars are one star
+            if (c == '*' && !tokens.empty() && tokens.back() == STAR) {
+                continue;
+            }
+            tokens.push_back(c == '*' ? STAR : static_cast<unsigned char>(foldCase(c)));
+        }
+        const Tokens exe = { '.', 'e', 'x', 'e' };
+        bool open = tokens.back() == STAR ||
+                    (tokens.size() >= exe.size() && std::equal(exe.begin(), exe.end(), tokens.end() - exe.size()));
+        nfa.patterns.push_back(tokens);
+        if (!open) {
+            tokens.insert(tokens.end(), exe.begin(), exe.end());
+            nfa.patterns.push_back(tokens);
+        }
+    }
+    if (nfa.patterns.empty()) {
+        error = "no process names";
+        return false;
+    }
+    nfa.build();
+
+    // Bytes no pattern mentions all behave alike and share class 0
+    uint8_t classOf[256] = {};
+    std::vector<int> representative(1, -1);
+    for (const Tokens& tokens : nfa.patterns) {
+        for (int token : tokens) {
+            if (token != STAR && classOf[token] == 0) {
+                classOf[token] = static_cast<uint8_t>(representative.size());
+                representative.push_back(token);
+            }
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; c++) {
+        classOf[c] = classOf[c - 'A' + 'a'];
+    }
+    size_t classCount = representative.size();
+
+    // Subset construction; state 0 is the empty set
+    std::map<std::vector<uint32_t>, uint16_t> ids;
+    std::vector<std::vector<uint32_t>> sets;
+    sets.emplace_back();
+    ids[sets[0]] = 0;
+    std::vector<uint32_t> initial;
+    for (uint32_t base : nfa.base) {
+        initial.push_back(base);
+    }
+    nfa.close(initial);
+    ids[initial] = 1;
+    sets.push_back(initial);
+
+    std::vector<uint16_t> next(2 * classCount, 0);
+    for (size_t state = 1; state < sets.size(); state++) {
+        for (size_t c = 0; c < classCount; c++) {
+            std::vector<uint32_t> target = nfa.step(sets[state], representative[c]);
+            auto it = ids.find(target);
+            if (it == ids.end()) {
+                if (sets.size() == MAX_STATES) {
+                    error = "too many patterns to combine";
+                    return false;
+                }
+                it = ids.emplace(target, static_cast<uint16_t>(sets.size())).first;
+                sets.push_back(target);
+                next.resize(sets.size() * classCount, 0);
+            }
+            next[state * classCount + c] = it->second;
+        }
+    }
+
+    std::vector<uint8_t> accepting(sets.size(), 0);
+    for (size_t state = 1; state < sets.size(); state++) {
+        accepting[state] = nfa.accepts(sets[state]) ? 1 : 0;
+    }
+
+    std::copy(classOf, classOf + 256, m_classOf);
+    m_classCount = classCount;
+    m_next = std::move(next);
+    m_accepting = std::move(accepting);
+    m_source = std::string(patterns);
+    return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Recognizes FL Studio's process names, compiled once into a DFA
+ *
+ * Patterns are a comma-separated list of names matched without regard to
+ * ASCII case, where * stands for any run of characters: "fl64" is an exact
+ * name, "fl*" a prefix and "fl*studio*" FL Studio's installer-style names.
+ * A pattern that doesn't end in * or .exe also matches with .exe appended,
+ * which is how Wine lists Windows executables.
+ *
+ * compile() turns the list into one deterministic automaton over byte
+ * classes with case folded in, so matches() reads each byte of the raw name
+ * once, with no copies or lowercasing, and stops at the first byte no
+ * pattern can continue with.
+ */
+class ProcessMatcher {
+    public:
+        static constexpr std::string_view DEFAULT_PATTERNS = "fl, fl64, fl32, flstudio, fl*studio*";
+        static const size_t MAX_STATES = 1024;
+
+    private:
+        uint8_t m_classOf[256];         // Byte to its column in m_next
+        size_t m_classCount;
+        std::vector<uint16_t> m_next;   // State x class; state 0 rejects everything, 1 is the start
+        std::vector<uint8_t> m_accepting;
+        std::string m_source;
+
+    public:
+        /**
+         * @brief Compiles DEFAULT_PATTERNS
+         */
+        ProcessMatcher();
+
+        /**
+         * @brief Compile a pattern list, replacing the current one only on success
+         * @param error Receives what is wrong with the list on failure
+         * @return false if the list is empty or too complex
+         */
+        bool compile(std::string_view patterns, std::string& error);
+
+        bool matches(std::string_view name) const {
+            size_t state = 1;
+            for (char c : name) {
+                state = m_next[state * m_classCount + m_classOf[static_cast<unsigned char>(c)]];
+                if (state == 0) {
+                    return false;
+                }
+            }
+            return m_accepting[state] != 0;
+        }
+
+        const std::string& source() const { return m_source; }
+        size_t stateCount() const { return m_accepting.size(); }
+};
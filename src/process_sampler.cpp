@@ -0,0 +1,194 @@
+#include "process_sampler.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+ProcessSampler::ProcessSampler()
+    : m_pid(0)
+#ifdef _WIN32
+    , m_process(nullptr)
+#else
+    , m_statFd(-1)
+    , m_statmFd(-1)
+#endif
+    , m_lastCpuTime(0)
+    , m_hasBaseline(false) {
+}
+
+ProcessSampler::~ProcessSampler() {
+    detach();
+}
+
+bool ProcessSampler::sample(Clock::TimePoint now) {
+    if (m_pid == 0) {
+        return false;
+    }
+    uint64_t cpuTime = 0;
+    uint64_t rssBytes = 0;
+    if (!read(cpuTime, rssBytes)) {
+        detach();
+        return false;
+    }
+
+    m_usage.rssBytes = rssBytes;
+    if (m_hasBaseline && now > m_lastSampleAt && cpuTime >= m_lastCpuTime) {
+        long long elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_lastSampleAt).count();
+#ifdef _WIN32
+        // FILETIME units of 100 ns
+        long long cpuUs = static_cast<long long>((cpuTime - m_lastCpuTime) / 10);
+#else
+        // Clock ticks
+        static const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+        long long cpuUs = static_cast<long long>(cpuTime - m_lastCpuTime) * 1000000 / ticksPerSecond;
+#endif
+        m_usage.cpuPercent = static_cast<int>((cpuUs * 100 + elapsedUs / 2) / elapsedUs);
+    }
+    m_lastCpuTime = cpuTime;
+    m_lastSampleAt = now;
+    m_hasBaseline = true;
+    return true;
+}
+
+#ifdef _WIN32
+
+bool ProcessSampler::attach(uint32_t pid) {
+    detach();
+    m_process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (!m_process) {
+        return false;
+    }
+    m_pid = pid;
+    return true;
+}
+
+void ProcessSampler::detach() {
+    if (m_process) {
+        CloseHandle(m_process);
+        m_process = nullptr;
+    }
+    m_pid = 0;
+    m_hasBaseline = false;
+    m_usage = ProcessUsage();
+}
+
+bool ProcessSampler::read(uint64_t& cpuTime, uint64_t& rssBytes) {
+    // The handle keeps the process object alive after exit, so ask
+    if (WaitForSingleObject(m_process, 0) == WAIT_OBJECT_0) {
+        return false;
+    }
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(m_process, &created, &exited, &kernel, &user)) {
+        return false;
+    }
+    ULARGE_INTEGER kernelTime = { { kernel.dwLowDateTime, kernel.dwHighDateTime } };
+    ULARGE_INTEGER userTime = { { user.dwLowDateTime, user.dwHighDateTime } };
+    cpuTime = kernelTime.QuadPart + userTime.QuadPart;
+
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(m_process, &pmc, sizeof(pmc))) {
+        rssBytes = pmc.WorkingSetSize;
+    }
+    return true;
+}
+
+#else
+
+bool ProcessSampler::attach(uint32_t pid) {
+    detach();
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+    m_statFd = open(path, O_RDONLY | O_CLOEXEC);
+    std::snprintf(path, sizeof(path), "/proc/%u/statm", pid);
+    m_statmFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (m_statFd < 0 || m_statmFd < 0) {
+        detach();
+        return false;
+    }
+    m_pid = pid;
+    return true;
+}
+
+void ProcessSampler::detach() {
+    if (m_statFd >= 0) {
+        close(m_statFd);
+        m_statFd = -1;
+    }
+    if (m_statmFd >= 0) {
+        close(m_statmFd);
+        m_statmFd = -1;
+    }
+    m_pid = 0;
+    m_hasBaseline = false;
+    m_usage = ProcessUsage();
+}
+
+namespace {
+
+// Parses the unsigned number at p, leaving p after it
+uint64_t parseNumber(const char*& p, const char* end) {
+    uint64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        p++;
+    }
+    return value;
+}
+
+} // namespace
+
+bool ProcessSampler::read(uint64_t& cpuTime, uint64_t& rssBytes) {
+    // Reads of a /proc file whose process has been reaped fail with ESRCH
+    char buffer[512];
+    ssize_t n = pread(m_statFd, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        return false;
+    }
+    const char* end = buffer + n;
+
+    // The name in parentheses may itself contain spaces and ')', so fields
+    // are counted from the last ')': state is field 3, utime 14 and stime 15
+    const char* p = end;
+    while (p > buffer && p[-1] != ')') {
+        p--;
+    }
+    if (p == buffer) {
+        return false;
+    }
+    // A zombie's files stay readable until its parent reaps it
+    if (end - p >= 2 && (p[1] == 'Z' || p[1] == 'X')) {
+        return false;
+    }
+    for (int field = 2; field < 14 && p < end; p++) {
+        if (*p == ' ') {
+            field++;
+        }
+    }
+    uint64_t utime = parseNumber(p, end);
+    if (p < end) {
+        p++;
+    }
+    uint64_t stime = parseNumber(p, end);
+    cpuTime = utime + stime;
+
+    // statm: total program size, then resident pages
+    n = pread(m_statmFd, buffer, sizeof(buffer), 0);
+    if (n <= 0) {
+        return false;
+    }
+    p = buffer;
+    end = buffer + n;
+    parseNumber(p, end);
+    if (p < end) {
+        p++;
+    }
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    rssBytes = parseNumber(p, end) * static_cast<uint64_t>(pageSize);
+    return true;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include "clock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * @brief FL Studio's CPU and memory use as of the last sample
+ */
+struct ProcessUsage {
+    int cpuPercent;         // Of one core, over the last sample interval; -1 until two samples
+    uint64_t rssBytes;      // Resident set (working set on Windows), 0 if unknown
+
+    ProcessUsage() : cpuPercent(-1), rssBytes(0) {}
+
+    bool operator==(const ProcessUsage& other) const {
+        return cpuPercent == other.cpuPercent && rssBytes == other.rssBytes;
+    }
+    bool operator!=(const ProcessUsage& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Samples one process's CPU time and resident memory without walking the process list
+ *
+ * attach() opens the process once: /proc/<pid>/stat and /proc/<pid>/statm
+ * on Linux, re-read in place with pread() on every sample; a query handle on
+ * Windows. A sample is then two small reads, no path lookups or allocations.
+ * CPU use is the CPU time consumed between two samples over the time between
+ * them, so the first sample after attach() only reports memory.
+ */
+class ProcessSampler {
+    private:
+        uint32_t m_pid;                 // 0 when detached
+#ifdef _WIN32
+        HANDLE m_process;
+#else
+        int m_statFd;
+        int m_statmFd;
+#endif
+        uint64_t m_lastCpuTime;         // In the platform's CPU time unit
+        Clock::TimePoint m_lastSampleAt;
+        bool m_hasBaseline;
+        ProcessUsage m_usage;
+
+        /**
+         * @brief Read the process's total CPU time and resident memory
+         * @return false if the process is gone
+         */
+        bool read(uint64_t& cpuTime, uint64_t& rssBytes);
+
+    public:
+        ProcessSampler();
+        ~ProcessSampler();
+
+        ProcessSampler(const ProcessSampler&) = delete;
+        ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+        /**
+         * @brief Start sampling pid, dropping the previous process
+         * @return false if the process can't be opened
+         */
+        bool attach(uint32_t pid);
+        void detach();
+
+        /**
+         * @brief Take a sample
+         * @return false if the process has exited, in which case the sampler detaches
+         */
+        bool sample(Clock::TimePoint now);
+
+        uint32_t pid() const { return m_pid; }
+        const ProcessUsage& usage() const { return m_usage; }
+};
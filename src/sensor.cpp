@@ -0,0 +1,192 @@
+#include "sensor.h"
+#include "memory_stats.h"
+#include "parser.h"
+#include "trace.h"
+#include <algorithm>
+
+// Passed by reference to std::chrono, so it needs a definition
+const int Sensor::AUDIO_SAFE_PROCESS_SCAN_MS;
+
+Sensor::Sensor(Clock& clock)
+    : m_clock(clock)
+    , m_sequence(0)
+    , m_lastWriteTimeMs(0)
+    , m_lastParsedAtMs(0)
+    , m_flStudioRunning(false)
+    , m_state(PresenceState::Idle)
+    , m_stateFileLoaded(false)
+    , m_absentDelayMs(0)
+    , m_audioSafe(false)
+    , m_inline(false)
+    , m_stopRequested(false)
+    , m_listener(nullptr) {
+}
+
+Sensor::~Sensor() {
+    stop();
+}
+
+void Sensor::configure(const std::string& stateFilePath, const PollPolicy& policy, const ProcessMatcher& matcher) {
+    m_stateFilePath = stateFilePath;
+    m_policy = policy;
+    m_monitor.setMatcher(matcher);
+}
+
+void Sensor::scan() {
+    TraceScope trace(Tracer::Span::SensorScan);
+    SensorSnapshot& snapshot = m_snapshots.back();
+    // Whatever the script writes from here on wakes the next wait
+    m_stateDirWatch.discard();
+    
+    auto now = m_clock.now();
+    bool processScanDue = !m_audioSafe.load(std::memory_order_relaxed) || !m_flStudioRunning ||
+                          now - m_lastProcessScan >= std::chrono::milliseconds(AUDIO_SAFE_PROCESS_SCAN_MS);
+    if (processScanDue) {
+        MemoryScope scope(MemoryStats::Subsystem::Monitor);
+        TraceScope processTrace(Tracer::Span::ProcessScan);
+        snapshot.flStudioRunning = m_monitor.searchForFLStudio();
+        m_lastProcessScan = now;
+    } else {
+        snapshot.flStudioRunning = true;
+    }
+    
+    bool loadedNow = false;
+    if (snapshot.flStudioRunning) {
+        snapshot.flStudioPid = m_monitor.pid();
+        sampleUsage(now);
+        snapshot.flStudioUsage = m_sampler.usage();
+        
+        MemoryScope scope(MemoryStats::Subsystem::Parser);
+        FLStudioData data = FLParser::getData(m_stateFilePath, m_arena);
+        snapshot.state = data.state;
+        snapshot.bpm = data.bpm;
+        snapshot.plugin.assign(data.plugin);
+        snapshot.projectName.assign(data.projectName);
+        loadedNow = data.loaded && !m_stateFileLoaded;
+        m_stateFileLoaded = data.loaded;
+        m_arena.reset();
+        
+        // The file is re-read every scan; a record's parse time is its first
+        if (data.writeTimeMs != m_lastWriteTimeMs) {
+            m_lastWriteTimeMs = data.writeTimeMs;
+            m_lastParsedAtMs = m_clock.unixTimeMs();
+        }
+        snapshot.writeTimeMs = m_lastWriteTimeMs;
+        snapshot.parsedAtMs = m_lastParsedAtMs;
+    } else {
+        snapshot.flStudioPid = 0;
+        m_stateFileLoaded = false;
+        snapshot.state = PresenceState::Idle;
+        snapshot.bpm = 0;
+        snapshot.plugin.clear();
+        snapshot.projectName.clear();
+        snapshot.writeTimeMs = 0;
+        snapshot.parsedAtMs = 0;
+        m_sampler.detach();
+        snapshot.flStudioUsage = ProcessUsage();
+    }
+    
+    snapshot.sequence = ++m_sequence;
+    snapshot.sensedAt = m_clock.now();
+    bool changed = snapshot.flStudioRunning != m_flStudioRunning || loadedNow;
+    m_flStudioRunning = snapshot.flStudioRunning;
+    m_state = snapshot.state;
+    m_snapshots.publish();
+    
+    if (changed && m_listener) {
+        m_listener->signal();
+    }
+}
+
+void Sensor::sampleUsage(Clock::TimePoint now) {
+    if (m_policy.sampleMs <= 0 || m_audioSafe.load(std::memory_order_relaxed)) {
+        return;
+    }
+    uint32_t pid = m_monitor.pid();
+    if (pid != m_sampler.pid()) {
+        // A new FL Studio process: its first sample is due at once
+        if (pid == 0 || !m_sampler.attach(pid)) {
+            m_sampler.detach();
+            return;
+        }
+    } else if (pid == 0 || now - m_lastSample < std::chrono::milliseconds(m_policy.sampleMs)) {
+        return;
+    }
+    TraceScope trace(Tracer::Span::ProcessSample);
+    m_sampler.sample(now);
+    m_lastSample = now;
+}
+
+int Sensor::nextDelayMs() {
+    if (m_flStudioRunning) {
+        m_absentDelayMs = 0;
+        bool active = m_state != PresenceState::Idle && !m_audioSafe.load(std::memory_order_relaxed);
+        return active ? m_policy.activeMs : m_policy.idleMs;
+    }
+    // Doubles from the idle interval; a state file write cuts it short
+    m_absentDelayMs = m_absentDelayMs == 0 ? m_policy.idleMs : std::min(m_absentDelayMs * 2, m_policy.absentMaxMs);
+    return m_absentDelayMs;
+}
+
+void Sensor::run() {
+    Tracer::setThreadName("sensor");
+    while (!m_stopRequested.load(std::memory_order_relaxed)) {
+        int delayMs = nextDelayMs();
+        // A freshly launched FL Studio shows up before its script has written
+        // the state file; that first write ends the wait rather than the next poll
+        if (m_flStudioRunning && m_stateFileLoaded) {
+            m_wake.wait(delayMs);
+        } else {
+            m_stateDirWatch.wait(m_wake, delayMs);
+        }
+        if (m_stopRequested.load(std::memory_order_relaxed)) {
+            break;
+        }
+        scan();
+    }
+}
+
+void Sensor::start() {
+    if (isRunning()) {
+        return;
+    }
+    
+    m_stateDirWatch.watchDirectoryOf(m_stateFilePath);
+    m_wake.clear();
+    
+    // The thread doesn't exist yet, so this thread may act as the producer
+    m_absentDelayMs = 0;
+    scan();
+    if (!m_clock.realTime()) {
+        // No thread can keep to simulated time; the consumer scans instead
+        m_inline = true;
+        m_nextScan = m_clock.now() + std::chrono::milliseconds(nextDelayMs());
+        return;
+    }
+    m_stopRequested.store(false);
+    m_thread = std::thread(&Sensor::run, this);
+}
+
+void Sensor::scanIfDue() {
+    if (!m_inline || m_clock.now() < m_nextScan) {
+        return;
+    }
+    scan();
+    m_nextScan = m_clock.now() + std::chrono::milliseconds(nextDelayMs());
+}
+
+int Sensor::msUntilNextScan() const {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(m_nextScan - m_clock.now()).count();
+    return remaining > 0 ? static_cast<int>(remaining) : 0;
+}
+
+void Sensor::stop() {
+    m_inline = false;
+    if (!m_thread.joinable()) {
+        return;
+    }
+    
+    m_stopRequested.store(true);
+    m_wake.signal();
+    m_thread.join();
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "arena.h"
+#include "clock.h"
+#include "discord_rp.h"
+#include "monitor.h"
+#include "poll_policy.h"
+#include "presence.h"
+#include "process_sampler.h"
+#include "triple_buffer.h"
+#include "wake_event.h"
+
+/**
+ * @brief Everything one scan found out about FL Studio
+ *
+ * Self-contained (no views into the sensor's arena) so it can cross threads.
+ */
+struct SensorSnapshot {
+    uint64_t sequence;              // Increments with every scan, 0 before the first
+    bool flStudioRunning;
+    uint32_t flStudioPid;           // 0 while FL Studio isn't running
+    PresenceState state;
+    int bpm;
+    InlineString<DiscordActivity::MAX_TEXT> plugin;
+    InlineString<DiscordActivity::MAX_TEXT> projectName;
+    Clock::TimePoint sensedAt;
+    long long writeTimeMs;          // Script's write_time for this record (Unix ms), 0 if unknown
+    long long parsedAtMs;           // When this record was first parsed (Unix ms)
+    ProcessUsage flStudioUsage;     // Latest sample, held over between samples
+    
+    SensorSnapshot()
+        : sequence(0), flStudioRunning(false), flStudioPid(0), state(PresenceState::Idle), bpm(0)
+        , writeTimeMs(0), parsedAtMs(0) {}
+};
+
+/**
+ * @brief Background thread that scans for FL Studio and reads the state file
+ *
+ * Keeps slow file and process-list I/O off the thread that talks to Discord.
+ * Snapshots are handed over through a TripleBuffer: the sensor never waits
+ * for the consumer, and the consumer always sees the latest complete scan.
+ * FL Studio starting or stopping is signaled through a WakeEvent (an
+ * eventfd on Linux). Neither path takes a lock, so a consumer busy on a
+ * Discord write can't hold up a scan.
+ *
+ * Scans follow the PollPolicy: the active interval while FL Studio is in
+ * use, the idle one while it sits open, and an exponential back-off up to
+ * absentMaxMs while it isn't running. The state file's directory is watched
+ * meanwhile, so the script's first write on launch triggers a scan at once.
+ *
+ * In audio-safe mode (FL Studio recording) scans drop to the idle interval
+ * and the process list is only walked every AUDIO_SAFE_PROCESS_SCAN_MS;
+ * the state file read in between notices when recording stops.
+ *
+ * FL Studio's CPU and memory use are sampled through the PID the process
+ * scan found, at most every sampleMs and not at all in audio-safe mode.
+ *
+ * With a clock that isn't real time (a simulation) there is no thread: the
+ * consumer calls scanIfDue() and includes msUntilNextScan() in its waits.
+ */
+class Sensor {
+    public:
+        static const int AUDIO_SAFE_PROCESS_SCAN_MS = 10000;
+
+    private:
+        Clock& m_clock;
+        std::string m_stateFilePath;
+        PollPolicy m_policy;
+        ProcessMonitor m_monitor;
+        ProcessSampler m_sampler;
+        TickArena m_arena;              // Sensor thread's scratch memory for parsing
+        uint64_t m_sequence;
+        long long m_lastWriteTimeMs;    // Record seen by the previous scan and when it was first parsed
+        long long m_lastParsedAtMs;
+        TripleBuffer<SensorSnapshot> m_snapshots;
+        
+        // Result of the last scan, for scheduling the next one (sensor thread)
+        bool m_flStudioRunning;
+        PresenceState m_state;
+        bool m_stateFileLoaded;         // The last scan parsed the state file
+        int m_absentDelayMs;            // Current back-off while FL Studio is absent, 0 when present
+        Clock::TimePoint m_lastProcessScan;
+        Clock::TimePoint m_lastSample;
+        Clock::TimePoint m_nextScan;    // When scanning inline
+        std::atomic<bool> m_audioSafe;
+        
+        std::thread m_thread;
+        bool m_inline;                  // Started without a thread (simulated clock)
+        std::atomic<bool> m_stopRequested;
+        WakeEvent m_wake;               // Interrupts the wait between scans on stop
+        DirectoryWatch m_stateDirWatch;
+        WakeEvent* m_listener;          // Signaled when FL Studio starts or stops running, or its state file first parses
+        
+        void run();
+        void scan();
+        void sampleUsage(Clock::TimePoint now);
+        int nextDelayMs();
+        
+    public:
+        explicit Sensor(Clock& clock = Clock::system());
+        ~Sensor();
+        
+        Sensor(const Sensor&) = delete;
+        Sensor& operator=(const Sensor&) = delete;
+        
+        void configure(const std::string& stateFilePath, const PollPolicy& policy, const ProcessMatcher& matcher);
+        
+        /**
+         * @brief Signal this event whenever a scan finds FL Studio started or stopped
+         * Also once its state file parses after a launch without one, so the
+         * real state doesn't wait out a poll interval. Set before start().
+         */
+        void setListener(WakeEvent* listener) { m_listener = listener; }
+        
+        /**
+         * @brief Scan less while FL Studio records (any thread); takes effect after the current wait
+         */
+        void setAudioSafe(bool audioSafe) { m_audioSafe.store(audioSafe, std::memory_order_relaxed); }
+        
+        /**
+         * @brief Scan once on the calling thread, then keep scanning in the background
+         * The first snapshot is available to update() as soon as this returns.
+         * Under a simulated clock later scans are left to scanIfDue().
+         */
+        void start();
+        
+        /**
+         * @brief Stop the background thread and wait for it
+         */
+        void stop();
+        
+        bool isRunning() const { return m_thread.joinable() || m_inline; }
+        
+        /**
+         * @brief Consumer: scan on the calling thread if started without a thread and a scan is due
+         */
+        void scanIfDue();
+        
+        /**
+         * @brief Milliseconds until scanIfDue() has work, 0 if it has now
+         * Only meaningful when scanning inline.
+         */
+        int msUntilNextScan() const;
+        
+        bool scansInline() const { return m_inline; }
+        
+        /**
+         * @brief Consumer: take the newest snapshot if there is one
+         * @return true if latest() changed
+         */
+        bool update() { return m_snapshots.update(); }
+        
+        /**
+         * @brief Consumer: snapshot taken by the last update()
+         */
+        const SensorSnapshot& latest() const { return m_snapshots.front(); }
+};
@@ -0,0 +1,84 @@
+#include "staleness.h"
+
+static uint64_t elapsedMicros(long long fromMs, long long toMs) {
+    return toMs > fromMs ? static_cast<uint64_t>(toMs - fromMs) * 1000 : 0;
+}
+
+bool StalenessTracker::isLive(const SensorSnapshot& sensed) {
+    return sensed.writeTimeMs != 0 && sensed.parsedAtMs - sensed.writeTimeMs <= MAX_RECORD_AGE_MS;
+}
+
+StalenessTracker::StalenessTracker()
+    : m_lastWriteTimeMs(0)
+    , m_queuedWriteTimeMs(0)
+    , m_queuedParsedAtMs(0)
+    , m_inFlight()
+    , m_nextSlot(0) {
+}
+
+void StalenessTracker::observe(const SensorSnapshot& sensed) {
+    if (!isLive(sensed) || sensed.writeTimeMs == m_lastWriteTimeMs) {
+        return;
+    }
+    m_lastWriteTimeMs = sensed.writeTimeMs;
+    m_scriptToParse.record(elapsedMicros(sensed.writeTimeMs, sensed.parsedAtMs));
+}
+
+void StalenessTracker::queued(const SensorSnapshot& sensed) {
+    if (!isLive(sensed)) {
+        queuedUnstamped();
+        return;
+    }
+    m_queuedWriteTimeMs = sensed.writeTimeMs;
+    m_queuedParsedAtMs = sensed.parsedAtMs;
+}
+
+void StalenessTracker::queuedUnstamped() {
+    m_queuedWriteTimeMs = 0;
+    m_queuedParsedAtMs = 0;
+}
+
+void StalenessTracker::sent(uint64_t nonce) {
+    if (nonce == 0) {
+        return;
+    }
+    if (m_queuedWriteTimeMs != 0) {
+        // More than MAX_PENDING in flight means some are timing out anyway
+        InFlight& slot = m_inFlight[m_nextSlot];
+        m_nextSlot = (m_nextSlot + 1) % DiscordRPC::MAX_PENDING;
+        slot.nonce = nonce;
+        slot.writeTimeMs = m_queuedWriteTimeMs;
+        slot.parsedAtMs = m_queuedParsedAtMs;
+    }
+    queuedUnstamped();
+}
+
+void StalenessTracker::acknowledged(uint64_t nonce, long long nowMs) {
+    for (size_t i = 0; i < DiscordRPC::MAX_PENDING; i++) {
+        InFlight& slot = m_inFlight[i];
+        if (slot.nonce == 0 || slot.nonce != nonce) {
+            continue;
+        }
+        m_parseToAck.record(elapsedMicros(slot.parsedAtMs, nowMs));
+        m_scriptToAck.record(elapsedMicros(slot.writeTimeMs, nowMs));
+        slot.nonce = 0;
+        return;
+    }
+}
+
+void StalenessTracker::forgetInFlight() {
+    for (size_t i = 0; i < DiscordRPC::MAX_PENDING; i++) {
+        m_inFlight[i].nonce = 0;
+    }
+    queuedUnstamped();
+}
+
+std::string StalenessTracker::report() const {
+    if (m_scriptToParse.count() == 0) {
+        return "";
+    }
+    return "Staleness:\n"
+        "  Script to parse: " + m_scriptToParse.summary() + "\n"
+        "  Parse to ack: " + m_parseToAck.summary() + "\n"
+        "  Script to ack: " + m_scriptToAck.summary() + "\n";
+}
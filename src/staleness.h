@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "discord_rp.h"
+#include "latency.h"
+#include "sensor.h"
+
+/**
+ * @brief How old the FL Studio state is by the time it is parsed and shown
+ *
+ * Follows each state file record from the script's write_time through its
+ * first parse to Discord's acknowledgement of the update built from it:
+ *
+ *   script to parse   write_time until the sensor first parsed the record
+ *   parse to ack      first parse until Discord answered the SET_ACTIVITY
+ *   script to ack     write_time until Discord answered: what users see
+ *
+ * Times are wall-clock milliseconds, compared across processes; negative
+ * differences (clock steps, whole-second write_time from older scripts)
+ * count as 0. Acknowledgements are read once per tick, like the request
+ * latencies. A record already older than MAX_RECORD_AGE_MS when parsed was
+ * left behind by an earlier session (the script rewrites the file every few
+ * seconds while it runs) and is not counted. Update thread only.
+ */
+class StalenessTracker {
+    public:
+        static const long long MAX_RECORD_AGE_MS = 60 * 1000;
+
+    private:
+        struct InFlight {
+            uint64_t nonce;             // 0 = free slot
+            long long writeTimeMs;
+            long long parsedAtMs;
+        };
+
+        LatencyHistogram m_scriptToParse;
+        LatencyHistogram m_parseToAck;
+        LatencyHistogram m_scriptToAck;
+        long long m_lastWriteTimeMs;    // Newest record counted in m_scriptToParse
+        long long m_queuedWriteTimeMs;  // Record behind the entry in DiscordRPC's queue, 0 if none
+        long long m_queuedParsedAtMs;
+        InFlight m_inFlight[DiscordRPC::MAX_PENDING];
+        size_t m_nextSlot;
+
+        static bool isLive(const SensorSnapshot& sensed);
+
+    public:
+        StalenessTracker();
+
+        /**
+         * @brief Count a scan's record if it is new
+         */
+        void observe(const SensorSnapshot& sensed);
+
+        /**
+         * @brief An activity built from this scan replaced the queued entry
+         */
+        void queued(const SensorSnapshot& sensed);
+
+        /**
+         * @brief Something not built from a record (Starting, a clear) replaced the queued entry
+         */
+        void queuedUnstamped();
+
+        /**
+         * @brief The queued entry went out as this request (flushQueue's result, 0 if nothing)
+         */
+        void sent(uint64_t nonce);
+
+        /**
+         * @brief Discord accepted the request with this nonce
+         * @param nowMs Wall clock (Unix ms) when the response was read
+         */
+        void acknowledged(uint64_t nonce, long long nowMs);
+
+        /**
+         * @brief Forget requests in flight when their connection goes away
+         * Nonces restart with the next DiscordRPC.
+         */
+        void forgetInFlight();
+
+        LatencySummary scriptToParse() const { return m_scriptToParse.summarize(); }
+        LatencySummary parseToAck() const { return m_parseToAck.summarize(); }
+        LatencySummary scriptToAck() const { return m_scriptToAck.summarize(); }
+
+        /**
+         * @brief Multi-line report, empty before the first record was seen
+         */
+        std::string report() const;
+};
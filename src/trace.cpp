@@ -0,0 +1,155 @@
+#include "trace.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+struct TraceEvent {
+    int64_t startNs;
+    int64_t endNs;
+    Tracer::Span span;
+    uint8_t thread;
+    std::atomic<bool> ready;    // Written out only once the recording thread has filled it
+};
+
+const char* const SPAN_NAMES[static_cast<size_t>(Tracer::Span::Count)] = {
+    "tick",
+    "sensor_scan",
+    "process_scan",
+    "process_sample",
+    "state_file_read",
+    "parse",
+    "diff",
+    "connect",
+    "serialize",
+    "ipc_write",
+    "response_poll",
+    "response_wait"
+};
+
+std::unique_ptr<TraceEvent[]> g_events;     // Allocated by the first start(), then kept
+std::atomic<size_t> g_count{0};
+std::atomic<uint64_t> g_dropped{0};
+int64_t g_originNs = 0;
+std::string g_outputPath = "flrp-trace.json";
+std::mutex g_controlMutex;                  // start/stop only, never taken while recording
+
+std::atomic<int> g_threadCount{0};
+const char* g_threadNames[Tracer::MAX_THREADS] = {};
+thread_local int t_thread = -1;
+
+int currentThread() {
+    if (t_thread < 0) {
+        int id = g_threadCount.fetch_add(1, std::memory_order_relaxed);
+        t_thread = id < Tracer::MAX_THREADS ? id : Tracer::MAX_THREADS - 1;
+    }
+    return t_thread;
+}
+
+void writeEvents(std::FILE* out, size_t count) {
+    std::fprintf(out, "{\"traceEvents\":[\n");
+    std::fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"FLRP\"}}");
+
+    int threads = g_threadCount.load();
+    for (int t = 0; t < threads && t < Tracer::MAX_THREADS; t++) {
+        std::fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                     t + 1, g_threadNames[t] ? g_threadNames[t] : "thread");
+    }
+
+    // Complete events in microseconds since start(); fractions keep sub-microsecond spans
+    for (size_t i = 0; i < count; i++) {
+        const TraceEvent& event = g_events[i];
+        if (!event.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        std::fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"flrp\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                     SPAN_NAMES[static_cast<size_t>(event.span)], event.thread + 1,
+                     static_cast<double>(event.startNs - g_originNs) / 1000.0,
+                     static_cast<double>(event.endNs - event.startNs) / 1000.0);
+    }
+
+    std::fprintf(out, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_spans\":%llu}}\n",
+                 static_cast<unsigned long long>(g_dropped.load()));
+}
+
+} // namespace
+
+int64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::setOutputPath(const std::string& path) {
+    std::lock_guard<std::mutex> lock(g_controlMutex);
+    g_outputPath = path;
+}
+
+const std::string& Tracer::outputPath() {
+    return g_outputPath;
+}
+
+void Tracer::setThreadName(const char* name) {
+    g_threadNames[currentThread()] = name;
+}
+
+void Tracer::record(Span span, int64_t startNs, int64_t endNs) {
+    // Pairs with start(): the buffer is visible before spans land in it
+    if (!s_enabled.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t index = g_count.fetch_add(1, std::memory_order_relaxed);
+    if (index >= CAPACITY) {
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = g_events[index];
+    event.startNs = startNs;
+    event.endNs = endNs;
+    event.span = span;
+    event.thread = static_cast<uint8_t>(currentThread());
+    event.ready.store(true, std::memory_order_release);
+}
+
+void Tracer::start() {
+    std::lock_guard<std::mutex> lock(g_controlMutex);
+    if (s_enabled.load()) {
+        return;
+    }
+    if (!g_events) {
+        g_events.reset(new TraceEvent[CAPACITY]);
+    }
+    size_t used = g_count.load() < CAPACITY ? g_count.load() : CAPACITY;
+    for (size_t i = 0; i < used; i++) {
+        g_events[i].ready.store(false, std::memory_order_relaxed);
+    }
+    g_count.store(0);
+    g_dropped.store(0);
+    g_originNs = now();
+    s_enabled.store(true);
+}
+
+bool Tracer::stop(size_t& events) {
+    std::lock_guard<std::mutex> lock(g_controlMutex);
+    events = 0;
+    if (!s_enabled.load()) {
+        return false;
+    }
+    s_enabled.store(false);
+
+    // Spans that were being recorded as tracing stopped are skipped if not yet ready
+    size_t count = g_count.load() < CAPACITY ? g_count.load() : CAPACITY;
+    for (size_t i = 0; i < count; i++) {
+        if (g_events[i].ready.load(std::memory_order_acquire)) {
+            events++;
+        }
+    }
+
+    std::FILE* out = std::fopen(g_outputPath.c_str(), "w");
+    if (!out) {
+        return false;
+    }
+    writeEvents(out, count);
+    return std::fclose(out) == 0;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Optional per-tick span recorder with Chrome trace export
+ *
+ * While tracing, TraceScope records where each loop iteration's time goes
+ * (process scan, state file read, parse, diff, serialize, IPC write,
+ * response handling) into a buffer preallocated by start(). stop() writes
+ * the spans as Chrome trace event JSON, which chrome://tracing and
+ * ui.perfetto.dev open directly.
+ *
+ * When tracing is off a TraceScope is a single relaxed load and branch.
+ * Spans are recorded lock-free from any thread; once the buffer is full
+ * further spans are counted and dropped.
+ */
+class Tracer {
+    public:
+        enum class Span : uint8_t {
+            Tick,
+            SensorScan,
+            ProcessScan,
+            ProcessSample,
+            StateFileRead,
+            Parse,
+            Diff,
+            Connect,
+            Serialize,
+            IpcWrite,
+            ResponsePoll,
+            ResponseWait,
+            Count
+        };
+
+        static const size_t CAPACITY = 64 * 1024;
+        static const int MAX_THREADS = 8;
+
+        /**
+         * @brief Set the file stop() writes to (TRACE_FILE)
+         */
+        static void setOutputPath(const std::string& path);
+
+        /**
+         * @brief Start recording, discarding spans from an earlier session
+         * The buffer is allocated on first use.
+         */
+        static void start();
+
+        /**
+         * @brief Stop recording and write the trace file
+         * @param events Receives the number of spans written
+         * @return false if tracing wasn't running or the file couldn't be written
+         */
+        static bool stop(size_t& events);
+
+        static const std::string& outputPath();
+
+        static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Name the calling thread in the trace (e.g. "main", "sensor")
+         * @param name String literal
+         */
+        static void setThreadName(const char* name);
+
+        static int64_t now();
+        static void record(Span span, int64_t startNs, int64_t endNs);
+
+    private:
+        static inline std::atomic<bool> s_enabled{false};
+};
+
+/**
+ * @brief Records the enclosing block as a span while tracing is on
+ */
+class TraceScope {
+    private:
+        Tracer::Span m_span;
+        int64_t m_start;
+
+    public:
+        explicit TraceScope(Tracer::Span span)
+            : m_span(span)
+            , m_start(Tracer::enabled() ? Tracer::now() : 0) {}
+
+        ~TraceScope() {
+            if (m_start != 0 && Tracer::enabled()) {
+                Tracer::record(m_span, m_start, Tracer::now());
+            }
+        }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope& operator=(const TraceScope&) = delete;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free latest-value exchange between one producer and one consumer thread
+ *
+ * Three slots: the producer fills the back slot and publishes it by swapping
+ * it with the middle one; the consumer swaps the middle slot with its front
+ * slot when something new was published. Neither side ever waits, and
+ * values the consumer didn't get to are overwritten, not queued.
+ */
+template <typename T>
+class TripleBuffer {
+    private:
+        static const uint8_t INDEX_MASK = 0x3;
+        static const uint8_t FRESH = 0x4;   // Middle slot holds a value the consumer hasn't taken
+
+        // Own cache lines so producer writes don't invalidate the consumer's slot
+        struct alignas(64) Slot {
+            T value;
+        };
+
+        Slot m_slots[3];
+        alignas(64) std::atomic<uint8_t> m_middle;
+        alignas(64) uint8_t m_back;         // Producer only
+        alignas(64) uint8_t m_front;        // Consumer only
+
+    public:
+        TripleBuffer() : m_slots(), m_middle(1), m_back(0), m_front(2) {}
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /**
+         * @brief Producer: slot to fill before publish()
+         * Holds a stale value, not the last one published.
+         */
+        T& back() { return m_slots[m_back].value; }
+
+        /**
+         * @brief Producer: make the back slot the latest value
+         */
+        void publish() {
+            uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_back | FRESH), std::memory_order_acq_rel);
+            m_back = previous & INDEX_MASK;
+        }
+
+        /**
+         * @brief Consumer: take the latest published value, if there is a new one
+         * @return true if front() changed
+         */
+        bool update() {
+            if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+            m_front = previous & INDEX_MASK;
+            return true;
+        }
+
+        /**
+         * @brief Consumer: value taken by the last successful update()
+         */
+        const T& front() const { return m_slots[m_front].value; }
+};
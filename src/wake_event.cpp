@@ -0,0 +1,157 @@
+#include "wake_event.h"
+#include <filesystem>
+
+#ifndef _WIN32
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+WakeEvent::WakeEvent()
+    : m_event(CreateEventA(nullptr, FALSE, FALSE, nullptr)) {
+}
+
+WakeEvent::~WakeEvent() {
+    if (m_event) {
+        CloseHandle(m_event);
+    }
+}
+
+void WakeEvent::signal() {
+    SetEvent(m_event);
+}
+
+bool WakeEvent::wait(int timeoutMs) {
+    // Window messages end the wait too, so the tray stays responsive through long waits
+    DWORD result = MsgWaitForMultipleObjects(1, &m_event, FALSE, static_cast<DWORD>(timeoutMs), QS_ALLINPUT);
+    return result == WAIT_OBJECT_0 || result == WAIT_OBJECT_0 + 1;
+}
+
+void WakeEvent::clear() {
+    ResetEvent(m_event);
+}
+
+DirectoryWatch::DirectoryWatch()
+    : m_change(INVALID_HANDLE_VALUE) {
+}
+
+DirectoryWatch::~DirectoryWatch() {
+    if (m_change != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(m_change);
+    }
+}
+
+bool DirectoryWatch::watchDirectoryOf(const std::string& filePath) {
+    if (m_change != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(m_change);
+    }
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::absolute(filePath, error).parent_path();
+    m_change = FindFirstChangeNotificationA(dir.string().c_str(), FALSE,
+                                            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    return m_change != INVALID_HANDLE_VALUE;
+}
+
+void DirectoryWatch::discard() {
+    while (m_change != INVALID_HANDLE_VALUE && WaitForSingleObject(m_change, 0) == WAIT_OBJECT_0) {
+        FindNextChangeNotification(m_change);
+    }
+}
+
+bool DirectoryWatch::wait(WakeEvent& wake, int timeoutMs) {
+    if (m_change == INVALID_HANDLE_VALUE) {
+        return wake.wait(timeoutMs);
+    }
+    HANDLE handles[2] = { wake.handle(), m_change };
+    DWORD result = WaitForMultipleObjects(2, handles, FALSE, static_cast<DWORD>(timeoutMs));
+    return result == WAIT_OBJECT_0 || result == WAIT_OBJECT_0 + 1;
+}
+
+#else
+
+WakeEvent::WakeEvent()
+    : m_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+}
+
+WakeEvent::~WakeEvent() {
+    if (m_fd != -1) {
+        close(m_fd);
+    }
+}
+
+void WakeEvent::signal() {
+    uint64_t one = 1;
+    ssize_t ignored = write(m_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void WakeEvent::clear() {
+    uint64_t value;
+    ssize_t ignored = read(m_fd, &value, sizeof(value));
+    (void)ignored;
+}
+
+bool WakeEvent::wait(int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (::poll(&pfd, 1, timeoutMs) <= 0) {
+        return false;
+    }
+    clear();
+    return true;
+}
+
+DirectoryWatch::DirectoryWatch()
+    : m_inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+}
+
+DirectoryWatch::~DirectoryWatch() {
+    if (m_inotify != -1) {
+        close(m_inotify);
+    }
+}
+
+bool DirectoryWatch::watchDirectoryOf(const std::string& filePath) {
+    if (m_inotify == -1) {
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::absolute(filePath, error).parent_path();
+    // The script writes in place (close-write) or replaces the file (moved-to)
+    return inotify_add_watch(m_inotify, dir.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO | IN_ONLYDIR) != -1;
+}
+
+void DirectoryWatch::discard() {
+    if (m_inotify == -1) {
+        return;
+    }
+    alignas(struct inotify_event) char buffer[4096];
+    while (read(m_inotify, buffer, sizeof(buffer)) > 0) {
+    }
+}
+
+bool DirectoryWatch::wait(WakeEvent& wake, int timeoutMs) {
+    struct pollfd pfds[2];
+    pfds[0].fd = wake.fd();
+    pfds[0].events = POLLIN;
+    pfds[0].revents = 0;
+    pfds[1].fd = m_inotify;
+    pfds[1].events = POLLIN;
+    pfds[1].revents = 0;
+
+    if (::poll(pfds, m_inotify != -1 ? 2 : 1, timeoutMs) <= 0) {
+        return false;
+    }
+    if (pfds[0].revents & POLLIN) {
+        wake.clear();
+    }
+    return true;
+}
+
+#endif
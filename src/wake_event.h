@@ -0,0 +1,92 @@
+#pragma once
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * @brief Cross-thread wakeup that can be waited on together with file descriptors
+ *
+ * signal() is sticky until a wait consumes it, so a signal sent while the
+ * waiting thread is busy isn't lost. Backed by an eventfd on Linux (so it
+ * can sit in a poll() next to inotify) and an auto-reset event on Windows.
+ */
+class WakeEvent {
+    private:
+#ifdef _WIN32
+        HANDLE m_event;
+#else
+        int m_fd;
+#endif
+
+    public:
+        WakeEvent();
+        ~WakeEvent();
+
+        WakeEvent(const WakeEvent&) = delete;
+        WakeEvent& operator=(const WakeEvent&) = delete;
+
+        /**
+         * @brief Wake the waiting thread (any thread)
+         */
+        void signal();
+
+        /**
+         * @brief Block until signaled or the timeout passes
+         * On Windows, also returns when the calling thread has window messages to pump.
+         * @return true if woken before the timeout
+         */
+        bool wait(int timeoutMs);
+
+        /**
+         * @brief Consume a pending signal without blocking
+         */
+        void clear();
+
+#ifdef _WIN32
+        HANDLE handle() const { return m_event; }
+#else
+        int fd() const { return m_fd; }
+#endif
+};
+
+/**
+ * @brief Notices files being created or rewritten in one directory
+ *
+ * inotify on Linux, a change notification on Windows. Only says that
+ * something changed; callers look for themselves.
+ */
+class DirectoryWatch {
+    private:
+#ifdef _WIN32
+        HANDLE m_change;
+#else
+        int m_inotify;
+#endif
+
+    public:
+        DirectoryWatch();
+        ~DirectoryWatch();
+
+        DirectoryWatch(const DirectoryWatch&) = delete;
+        DirectoryWatch& operator=(const DirectoryWatch&) = delete;
+
+        /**
+         * @brief Start watching the directory holding this file
+         * @return false if the directory can't be watched (waits then only time out)
+         */
+        bool watchDirectoryOf(const std::string& filePath);
+
+        /**
+         * @brief Forget changes seen so far; call before looking at the directory
+         */
+        void discard();
+
+        /**
+         * @brief Block until the directory changes, wake is signaled or the timeout passes
+         * Returns at once for a change since the last discard().
+         * @return true if woken before the timeout
+         */
+        bool wait(WakeEvent& wake, int timeoutMs);
+};
@@ -0,0 +1,121 @@
+// How late a 1 ms audio-style timer wakes while FLRP-like work runs on its core,
+// with the busy process at normal priority and in audio-safe mode
+#include "test_support.h"
+#include "audio_safe.h"
+#include <algorithm>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const int PERIODS = 2000;
+const int PERIOD_NS = 1000000;
+const int BUSY_THREADS = 2;
+
+long long nanoseconds(const timespec& time) {
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+// Child process burning BUSY_THREADS threads on cpu; reports its scheduling
+// policy through the pipe once running
+pid_t startBusy(int cpu, bool audioSafe, int reportFd) {
+    pid_t parent = getpid();
+    pid_t child = fork();
+    if (child != 0) {
+        return child;
+    }
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+    sched_setaffinity(0, sizeof(one), &one);
+    for (int i = 0; i < BUSY_THREADS; i++) {
+        std::thread([] {
+            for (volatile unsigned long spin = 0;; spin++) {
+            }
+        }).detach();
+    }
+    AudioSafeMode mode;
+    if (audioSafe) {
+        mode.enter(-1, static_cast<uint32_t>(parent));
+    }
+    int policy = sched_getscheduler(0);
+    ssize_t ignored = write(reportFd, &policy, sizeof(policy));
+    (void)ignored;
+    for (;;) {
+        pause();
+    }
+}
+
+struct Lateness {
+    long long p50Us;
+    long long p99Us;
+    long long maxUs;
+};
+
+Lateness measure() {
+    std::vector<long long> late;
+    late.reserve(PERIODS);
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    for (int i = 0; i < PERIODS; i++) {
+        next.tv_nsec += PERIOD_NS;
+        if (next.tv_nsec >= 1000000000) {
+            next.tv_nsec -= 1000000000;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        late.push_back(nanoseconds(now) - nanoseconds(next));
+        // A little DSP work per period
+        for (volatile int work = 0; work < 20000; work++) {
+        }
+    }
+    std::sort(late.begin(), late.end());
+    return Lateness{late[late.size() / 2] / 1000, late[late.size() * 99 / 100] / 1000, late.back() / 1000};
+}
+
+Lateness run(const char* name, int cpu, bool busy, bool audioSafe) {
+    pid_t child = -1;
+    if (busy) {
+        int report[2];
+        CHECK(pipe(report) == 0);
+        child = startBusy(cpu, audioSafe, report[1]);
+        int policy = -1;
+        CHECK(read(report[0], &policy, sizeof(policy)) == sizeof(policy));
+        close(report[0]);
+        close(report[1]);
+        // In audio-safe mode the busy process is never left at normal priority
+        CHECK(audioSafe ? policy == SCHED_IDLE || policy == SCHED_BATCH : policy == SCHED_OTHER);
+    }
+    Lateness result = measure();
+    if (child > 0) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+    }
+    std::printf("%-28s p50 %6lld us  p99 %6lld us  max %6lld us\n", name, result.p50Us, result.p99Us, result.maxUs);
+    return result;
+}
+
+} // namespace
+
+int main() {
+    // The "audio engine" is this process, on the first allowed CPU
+    cpu_set_t allowed;
+    CHECK(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed)) {
+        cpu++;
+    }
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+    sched_setaffinity(0, sizeof(one), &one);
+
+    run("no other load", cpu, false, false);
+    run("busy, normal priority", cpu, true, false);
+    run("busy, audio-safe mode", cpu, true, true);
+    return test::result();
+}
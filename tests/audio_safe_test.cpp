@@ -0,0 +1,141 @@
+// Audio-safe mode: whatever enter() does to scheduling, leave() can undo
+#include "test_support.h"
+#include "audio_safe.h"
+#include <fstream>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+pid_t currentTid() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// Priority goes down on every thread and comes back on leave()
+void checkPriority(const char* who) {
+    std::atomic<pid_t> helperTid(0);
+    std::atomic<bool> done(false);
+    std::thread helper([&] {
+        helperTid.store(currentTid());
+        while (!done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    while (helperTid.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    int before = sched_getscheduler(0);
+    int expected = AudioSafeMode::priorityRestorable() ? SCHED_IDLE : SCHED_BATCH;
+    {
+        AudioSafeMode mode;
+        mode.enter(-1, 0);
+        CHECK(mode.active());
+        CHECK(mode.priorityLowered());
+        CHECK(mode.idlePriority() == (expected == SCHED_IDLE));
+        CHECK(sched_getscheduler(0) == expected);
+        CHECK(sched_getscheduler(helperTid.load()) == expected);
+
+        mode.leave();
+        CHECK(!mode.active());
+        CHECK(!mode.priorityLowered());
+        CHECK(sched_getscheduler(0) == before);
+        CHECK(sched_getscheduler(helperTid.load()) == before);
+    }
+    done.store(true);
+    helper.join();
+    std::printf("%s: lowered to %s and restored\n", who, expected == SCHED_IDLE ? "SCHED_IDLE" : "SCHED_BATCH");
+}
+
+// Same as an unprivileged user without RLIMIT_NICE headroom, the common desktop case
+void checkPriorityUnprivileged() {
+    std::fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        struct rlimit noNice = {0, 0};
+        if (setrlimit(RLIMIT_NICE, &noNice) != 0 || setgid(65534) != 0 || setuid(65534) != 0) {
+            _exit(2);
+        }
+        CHECK(!AudioSafeMode::priorityRestorable());
+        checkPriority("unprivileged");
+        std::fflush(stdout);
+        _exit(test::result());
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+long threadTicks(pid_t pid) {
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string text((std::istreambuf_iterator<char>(stat)), std::istreambuf_iterator<char>());
+    size_t field = text.rfind(')');
+    for (int index = 3; index <= 14 && field != std::string::npos; index++) {
+        field = text.find(' ', field + 1);
+    }
+    return field == std::string::npos ? 0 : std::strtol(text.c_str() + field + 1, nullptr, 10);
+}
+
+// The pinned CPU is one the other process isn't busy on
+void checkCpuChoice() {
+    cpu_set_t allowed;
+    CHECK(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+    if (CPU_COUNT(&allowed) < 2) {
+        std::printf("single CPU: pinning not exercised\n");
+        return;
+    }
+    int last = -1;
+    for (int i = 0; i < CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &allowed)) {
+            last = i;
+        }
+    }
+
+    // Stands in for FL Studio's audio engine, busy on the CPU the old rule picked
+    pid_t busy = fork();
+    if (busy == 0) {
+        cpu_set_t one;
+        CPU_ZERO(&one);
+        CPU_SET(last, &one);
+        sched_setaffinity(0, sizeof(one), &one);
+        for (volatile unsigned long spin = 0;; spin++) {
+        }
+    }
+    auto start = std::chrono::steady_clock::now();
+    while (threadTicks(busy) < 10 && test::msSince(start) < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    {
+        AudioSafeMode mode;
+        mode.enter(-1, static_cast<uint32_t>(busy));
+        CHECK(mode.pinnedCpu() >= 0);
+        CHECK(mode.pinnedCpu() != last);
+        mode.leave();
+        CHECK(mode.pinnedCpu() == -1);
+
+        // AUDIO_SAFE_CPU wins
+        mode.enter(last, static_cast<uint32_t>(busy));
+        CHECK(mode.pinnedCpu() == last);
+        mode.leave();
+    }
+    cpu_set_t after;
+    CHECK(sched_getaffinity(0, sizeof(after), &after) == 0 && CPU_EQUAL(&after, &allowed));
+
+    kill(busy, SIGKILL);
+    waitpid(busy, nullptr, 0);
+}
+
+} // namespace
+
+int main() {
+    checkPriority(geteuid() == 0 ? "root" : "this user");
+    if (geteuid() == 0) {
+        checkPriorityUnprivileged();
+    }
+    checkCpuChoice();
+    return test::result();
+}
@@ -0,0 +1,62 @@
+// Control socket: owner-only from the moment it exists, and answering commands
+#include "test_support.h"
+#include "control_server.h"
+#include "app_state.h"
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+std::string command(const std::string& path, const char* line) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    std::string reply;
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        ssize_t ignored = write(fd, line, std::strlen(line));
+        (void)ignored;
+        char buffer[4096];
+        ssize_t n;
+        while (reply.find('\n') == std::string::npos && (n = read(fd, buffer, sizeof(buffer))) > 0) {
+            reply.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    close(fd);
+    return reply;
+}
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    std::string path = dir.file("flrp.sock");
+
+    // Even a permissive umask leaves the socket owner-only
+    mode_t previousMask = umask(0);
+    AppState app;
+    ControlServer server(app);
+    CHECK(server.start(path));
+    CHECK(umask(previousMask) == 0);
+
+    struct stat info;
+    CHECK(stat(path.c_str(), &info) == 0);
+    CHECK(S_ISSOCK(info.st_mode));
+    CHECK((info.st_mode & (S_IRWXG | S_IRWXO)) == 0);
+
+    std::string status = command(path, "status\n");
+    CHECK(status.find("\"ok\":true") != std::string::npos);
+    CHECK(status.find("\"state\":\"stopped\"") != std::string::npos);
+    CHECK(command(path, "bogus\n").find("\"ok\":false") != std::string::npos);
+
+    // A second instance doesn't take over a socket that still answers
+    ControlServer second(app);
+    CHECK(!second.start(path));
+
+    server.stop();
+    CHECK(access(path.c_str(), F_OK) != 0);
+    return test::result();
+}
@@ -0,0 +1,148 @@
+// Nothing waits on a Discord that stops answering longer than its budget
+#include "test_support.h"
+#include "discord_rp.h"
+#include "ipc_connector.h"
+#include "clock.h"
+#include <cstdlib>
+
+namespace {
+
+const char* const CLIENT_ID = "1396127471342194719";
+
+DiscordActivity composing() {
+    DiscordActivity activity;
+    activity.state = PresenceState::Composing;
+    activity.bpm = 120;
+    return activity;
+}
+
+// Handshake budget covers a Discord that accepts but never sends READY
+void testHandshakeStall(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::StallHandshake);
+    IpcConnector connector;
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    timeouts.handshakeMs = 200;
+    DiscordRPC rpc(CLIENT_ID, timeouts);
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!rpc.connect(connector, arena));
+    double elapsedMs = test::msSince(start);
+    CHECK(elapsedMs >= 190 && elapsedMs < 1000);
+    CHECK(!rpc.isConnected());
+    CHECK(rpc.lastDisconnectReason() == "handshake timed out");
+    std::printf("stalled handshake gave up after %.1f ms (budget 200 ms)\n", elapsedMs);
+}
+
+// A handshake Discord refuses fails at once, not when the budget runs out
+void testHandshakeRejected(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::RejectHandshake);
+    IpcConnector connector;
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    timeouts.handshakeMs = 2000;
+    DiscordRPC rpc(CLIENT_ID, timeouts);
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!rpc.connect(connector, arena));
+    double elapsedMs = test::msSince(start);
+    CHECK(elapsedMs < 500);
+    CHECK(rpc.lastDisconnectReason() == "handshake rejected");
+    std::printf("rejected handshake failed after %.1f ms (budget 2000 ms)\n", elapsedMs);
+}
+
+// Hanging up during the handshake is reported as such, not as a timeout
+void testHandshakeClosed(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::CloseOnHandshake);
+    IpcConnector connector;
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    timeouts.handshakeMs = 2000;
+    DiscordRPC rpc(CLIENT_ID, timeouts);
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!rpc.connect(connector, arena));
+    CHECK(test::msSince(start) < 500);
+    CHECK(rpc.lastDisconnectReason() == "closed by Discord");
+}
+
+// A slow READY inside the budget still connects
+void testSlowReady(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::SlowReady);
+    discord.setReadyDelayMs(100);
+    IpcConnector connector;
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    timeouts.handshakeMs = 1000;
+    DiscordRPC rpc(CLIENT_ID, timeouts);
+
+    CHECK(rpc.connect(connector, arena));
+    CHECK(rpc.connectLatencies().count() == 1);
+}
+
+// The blocking helper returns within the request budget
+void testBlockingRequestStall(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::StallResponses);
+    IpcConnector connector;
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    timeouts.requestMs = 200;
+    DiscordRPC rpc(CLIENT_ID, timeouts);
+    CHECK(rpc.connect(connector, arena));
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!rpc.updateActivity(composing(), arena));
+    double elapsedMs = test::msSince(start);
+    CHECK(elapsedMs >= 190 && elapsedMs < 1000);
+    std::printf("stalled SET_ACTIVITY gave up after %.1f ms (budget 200 ms)\n", elapsedMs);
+}
+
+// Unanswered requests time out, the follow-up ping times out and the link drops
+void testResponseStall(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::StallResponses);
+    SimulatedClock clock(1800000000000LL);
+    IpcConnector connector(clock);
+    TickArena arena;
+    DiscordTimeouts timeouts;
+    DiscordRPC rpc(CLIENT_ID, timeouts, PresenceFormat(), clock);
+    CHECK(rpc.connect(connector, arena));
+
+    uint64_t nonce = rpc.sendActivity(composing(), arena);
+    CHECK(nonce != 0);
+    discord.settle();
+    CHECK(rpc.pollResponses(arena));
+    CHECK(rpc.pendingRequests() == 1);
+
+    clock.advance(std::chrono::milliseconds(timeouts.requestMs));
+    CHECK(rpc.pollResponses(arena));
+    DiscordResponse response;
+    CHECK(rpc.nextResponse(response));
+    CHECK(response.nonce == nonce);
+    CHECK(!response.ok);
+    CHECK(response.errorCode == DiscordResponse::ERROR_TIMED_OUT);
+    CHECK(rpc.timedOutRequestCount() == 1);
+    CHECK(rpc.pendingRequests() == 0);
+
+    // The timeout sent a ping, which goes unanswered too
+    discord.settle();
+    CHECK(discord.frames().back().opcode == 3);
+    clock.advance(std::chrono::milliseconds(timeouts.pingMs));
+    CHECK(!rpc.pollResponses(arena));
+    CHECK(!rpc.isConnected());
+    CHECK(rpc.lastDisconnectReason() == "ping timed out");
+}
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+
+    testHandshakeStall(dir.path());
+    testHandshakeRejected(dir.path());
+    testHandshakeClosed(dir.path());
+    testSlowReady(dir.path());
+    testBlockingRequestStall(dir.path());
+    testResponseStall(dir.path());
+    return test::result();
+}
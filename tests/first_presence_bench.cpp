@@ -0,0 +1,155 @@
+// Time from FL Studio launching to Discord receiving its presence, with the
+// connection kept warm across sessions and, for comparison, made at launch
+#include "test_support.h"
+#include "app_state.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const int LAUNCHES = 5;
+
+// Discord takes this long to send READY, so a handshake on the launch path shows
+const int READY_DELAY_MS = 50;
+
+const int TIMEOUT_MS = 5000;
+
+bool isClear(const std::string& body) {
+    return body.find("\"activity\":{") == std::string::npos;
+}
+
+bool isComposing(const std::string& body) {
+    return !isClear(body) && body.find("Composing") != std::string::npos;
+}
+
+// Wait for a SET_ACTIVITY after the first `after` that satisfies match
+template <typename Match>
+bool waitForActivity(const test::FakeDiscord& discord, size_t after, Match match) {
+    auto start = std::chrono::steady_clock::now();
+    while (test::msSince(start) < TIMEOUT_MS) {
+        std::vector<std::string> activities = discord.activities();
+        for (size_t i = after; i < activities.size(); i++) {
+            if (match(activities[i])) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return false;
+}
+
+AppSettings settingsFor(const std::string& statePath) {
+    AppSettings settings;
+    settings.stateFilePath = statePath;
+    settings.audioSafe = false;
+    return settings;
+}
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// FLRP already running with Discord connected; FL Studio launches and closes
+std::vector<double> warmLaunches(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::SlowReady);
+    discord.setReadyDelayMs(READY_DELAY_MS);
+    test::FlStudioStub flStudio;
+    std::string statePath = dir + "/fl_studio_state.json";
+
+    AppState app;
+    app.initialize(settingsFor(statePath));
+    app.startMonitoring();
+    std::thread loop([&app] {
+        while (app.update()) {
+            app.waitForNextTick();
+        }
+    });
+
+    // The handshake happens at startup, before FL Studio is around
+    auto start = std::chrono::steady_clock::now();
+    while (!app.getStatus().discordConnected && test::msSince(start) < TIMEOUT_MS) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(app.getStatus().discordConnected);
+    CHECK(discord.activities().empty());
+
+    // The first launch finds no state file until the script writes one
+    std::vector<double> latencies;
+    for (int launch = 0; launch < LAUNCHES; launch++) {
+        size_t before = discord.activities().size();
+        auto launched = std::chrono::steady_clock::now();
+        flStudio.start();
+        test::writeStateFile(statePath, "Composing", 120, "", Clock::system().unixTimeMs());
+        CHECK(waitForActivity(discord, before, isComposing));
+        latencies.push_back(test::msSince(launched));
+
+        // Closing FL Studio clears the presence and keeps the connection
+        before = discord.activities().size();
+        flStudio.stop();
+        CHECK(waitForActivity(discord, before, isClear));
+    }
+    CHECK(discord.connections() == 1);
+
+    app.requestExit();
+    loop.join();
+    return latencies;
+}
+
+// FL Studio already running when FLRP starts: connect, handshake and first presence together
+std::vector<double> coldStarts(const std::string& dir) {
+    test::FakeDiscord discord(dir, test::FakeDiscord::Mode::SlowReady);
+    discord.setReadyDelayMs(READY_DELAY_MS);
+    test::FlStudioStub flStudio;
+    std::string statePath = dir + "/fl_studio_state.json";
+    flStudio.start();
+
+    std::vector<double> latencies;
+    for (int launch = 0; launch < LAUNCHES; launch++) {
+        size_t before = discord.activities().size();
+        test::writeStateFile(statePath, "Composing", 120, "", Clock::system().unixTimeMs());
+        auto started = std::chrono::steady_clock::now();
+        AppState app;
+        app.initialize(settingsFor(statePath));
+        app.startMonitoring();
+        std::thread loop([&app] {
+            while (app.update()) {
+                app.waitForNextTick();
+            }
+        });
+        CHECK(waitForActivity(discord, before, isComposing));
+        latencies.push_back(test::msSince(started));
+        app.requestExit();
+        loop.join();
+    }
+    CHECK(discord.connections() == LAUNCHES);
+    return latencies;
+}
+
+void report(const char* name, const std::vector<double>& latencies) {
+    std::printf("%-36s median %7.1f ms  min %7.1f ms  max %7.1f ms\n", name, median(latencies),
+                *std::min_element(latencies.begin(), latencies.end()),
+                *std::max_element(latencies.begin(), latencies.end()));
+}
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+    Logger::start(LogLevel::Warn);
+
+    std::vector<double> warm = warmLaunches(dir.path());
+    std::vector<double> cold = coldStarts(dir.path());
+    Logger::stop();
+
+    report("launch, connection kept warm", warm);
+    report("launch, connecting then", cold);
+    // The warm path skips the handshake Discord takes READY_DELAY_MS to answer
+    CHECK(median(warm) < median(cold));
+    // Not even the first launch, before the script has ever written its file, waits for a poll
+    CHECK(*std::max_element(warm.begin(), warm.end()) < PollPolicy().activeMs);
+    return test::result();
+}
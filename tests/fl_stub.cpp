@@ -0,0 +1,8 @@
+#include <unistd.h>
+
+// Stands in for FL Studio: FLRP only needs a process called FL64.exe
+int main() {
+    for (;;) {
+        pause();
+    }
+}
@@ -0,0 +1,137 @@
+// Discord endpoint discovery: inotify wake-up, hint retries and backoff
+#include "test_support.h"
+#include "ipc_connector.h"
+#include "clock.h"
+#include <cstdlib>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// A discord-ipc-N socket file, bound and optionally listening
+class Endpoint {
+    private:
+        std::string m_path;
+        int m_fd;
+
+    public:
+        Endpoint(const std::string& dir, int index, bool listening)
+            : m_path(dir + "/discord-ipc-" + std::to_string(index)) {
+            m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            sockaddr_un addr = {};
+            addr.sun_family = AF_UNIX;
+            std::strncpy(addr.sun_path, m_path.c_str(), sizeof(addr.sun_path) - 1);
+            CHECK(bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+            if (listening) {
+                listen();
+            }
+        }
+
+        ~Endpoint() {
+            close(m_fd);
+            unlink(m_path.c_str());
+        }
+
+        void listen() { CHECK(::listen(m_fd, 4) == 0); }
+};
+
+bool openAndRecord(IpcConnector& connector) {
+    IpcHandle handle = INVALID_IPC_HANDLE;
+    bool opened = connector.open(handle);
+    if (opened) {
+        close(handle);
+    }
+    connector.recordResult(opened);
+    return opened;
+}
+
+// Attempts until Discord's endpoint exists wait on inotify, not a timer
+void testWaitsForEndpoint(const std::string& dir) {
+    IpcConnector connector;
+    CHECK(connector.attemptDue());
+    CHECK(!openAndRecord(connector));
+    CHECK(connector.waitingForEndpoint());
+    CHECK(!connector.attemptDue());
+    CHECK(connector.failures() == 0);
+
+    Endpoint endpoint(dir, 3, true);
+    CHECK(connector.attemptDue());
+    CHECK(openAndRecord(connector));
+    CHECK(connector.preferredEndpoint() == 3);
+}
+
+// waitForEndpoint() returns as soon as the socket is created
+void testWakesOnCreation(const std::string& dir) {
+    IpcConnector connector;
+    CHECK(!openAndRecord(connector));
+    CHECK(connector.waitingForEndpoint());
+
+    WakeEvent interrupt;
+    auto start = std::chrono::steady_clock::now();
+    std::thread creator([&dir] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        Endpoint endpoint(dir, 1, true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    });
+    bool appeared = connector.waitForEndpoint(5000, interrupt);
+    double waitedMs = test::msSince(start);
+    CHECK(appeared);
+    CHECK(waitedMs < 1000);
+    CHECK(connector.attemptDue());
+    CHECK(openAndRecord(connector));
+    CHECK(connector.preferredEndpoint() == 1);
+    creator.join();
+    std::printf("woke %.1f ms after waiting started (endpoint created at 50 ms)\n", waitedMs);
+}
+
+// A created endpoint that isn't listening yet is retried shortly, without backoff
+void testRetriesCreatedEndpoint(const std::string& dir) {
+    IpcConnector connector;
+    CHECK(!openAndRecord(connector));
+
+    Endpoint endpoint(dir, 5, false);
+    CHECK(connector.attemptDue());
+    CHECK(!openAndRecord(connector));
+    CHECK(!connector.waitingForEndpoint());
+    CHECK(connector.failures() == 0);
+    CHECK(connector.retryDelayMs() <= 10);
+
+    endpoint.listen();
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));
+    CHECK(connector.attemptDue());
+    CHECK(openAndRecord(connector));
+    CHECK(connector.preferredEndpoint() == 5);
+}
+
+// One that never starts listening is given up on after a few retries
+void testGivesUpOnCreatedEndpoint(const std::string& dir) {
+    IpcConnector connector;
+    CHECK(!openAndRecord(connector));
+
+    Endpoint endpoint(dir, 7, false);
+    int attempts = 0;
+    do {
+        std::this_thread::sleep_for(std::chrono::milliseconds(connector.retryDelayMs() + 1));
+        CHECK(connector.attemptDue());
+        CHECK(!openAndRecord(connector));
+        attempts++;
+    } while (attempts < 20 && !connector.waitingForEndpoint());
+    // The first try plus HINT_RETRIES
+    CHECK(attempts == 6);
+    CHECK(connector.waitingForEndpoint());
+}
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+
+    testWaitsForEndpoint(dir.path());
+    testWakesOnCreation(dir.path());
+    testRetriesCreatedEndpoint(dir.path());
+    testGivesUpOnCreatedEndpoint(dir.path());
+    return test::result();
+}
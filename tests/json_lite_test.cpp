@@ -0,0 +1,164 @@
+// FlatJsonReader on what the script writes, and on what a half-written or
+// hand-edited state file can contain
+#include "test_support.h"
+#include "json_lite.h"
+#include "parser.h"
+#include <cstdio>
+
+namespace {
+
+struct Read {
+    bool ok;
+    std::string text;
+};
+
+// The value of the only member of json, read as a string
+Read readOnlyString(TickArena& arena, std::string_view json) {
+    FlatJsonReader reader(json.data(), json.size());
+    std::string_view key;
+    std::string_view text;
+    Read result = {false, ""};
+    if (reader.nextKey(key) && reader.readString(arena, text)) {
+        result.ok = true;
+        result.text.assign(text);
+    }
+    arena.reset();
+    return result;
+}
+
+void checkEscapes(TickArena& arena) {
+    CHECK(readOnlyString(arena, R"({"s":"plain"})").text == "plain");
+    CHECK(readOnlyString(arena, R"({"s":"a\"b\\c\/d\b\f\n\r\t"})").text == "a\"b\\c/d\b\f\n\r\t");
+    CHECK(readOnlyString(arena, R"({"s":"caf\u00e9 \u20AC"})").text == "caf\xC3\xA9 \xE2\x82\xAC");
+    CHECK(readOnlyString(arena, R"({"s":"\u0041A\u0030"})").text == "AA0");
+
+    // Python's json.dump writes non-BMP characters as surrogate pairs
+    CHECK(readOnlyString(arena, R"({"s":"\ud83c\udfb9 Keys"})").text == "\xF0\x9F\x8E\xB9 Keys");
+    CHECK(readOnlyString(arena, R"({"s":"\uD83C\uDFB9"})").text == "\xF0\x9F\x8E\xB9");
+
+    // Unknown escapes and bad hex fail the string
+    CHECK(!readOnlyString(arena, R"({"s":"\q"})").ok);
+    CHECK(!readOnlyString(arena, R"({"s":"\u00g0"})").ok);
+}
+
+void checkLoneSurrogates(TickArena& arena) {
+    // Unpaired halves decode to U+FFFD rather than to invalid UTF-8
+    const std::string replacement = "\xEF\xBF\xBD";
+    CHECK(readOnlyString(arena, R"({"s":"\ud83c"})").text == replacement);
+    CHECK(readOnlyString(arena, R"({"s":"\ud83cx"})").text == replacement + "x");
+    CHECK(readOnlyString(arena, R"({"s":"\udfb9x"})").text == replacement + "x");
+    CHECK(readOnlyString(arena, R"({"s":"\ud83c\u0041"})").text == replacement + "A");
+    CHECK(readOnlyString(arena, R"({"s":"\ud83c\ud83c\udfb9"})").text == replacement + "\xF0\x9F\x8E\xB9");
+
+    // A low half cut short is an error, not a character
+    CHECK(!readOnlyString(arena, R"({"s":"\ud83c\udf"})").ok);
+    CHECK(!readOnlyString(arena, R"({"s":"\ud8"})").ok);
+}
+
+// Every prefix of a valid file, as a reader racing the script's write sees it
+void checkTruncation(TickArena& arena) {
+    const std::string json = R"({"state":"Composing","bpm":128.0,"plugin":"Pro-Q \"3\" \u00e9\ud83c\udfb9",)"
+                             R"("meta":{"a":[1,{"b":"}"}]},"write_time":1800000000.123})";
+    for (size_t length = 0; length < json.size(); length++) {
+        std::string prefix = json.substr(0, length);
+        FLStudioData data;
+        bool ok = FLParser::parse(prefix.data(), prefix.size(), arena, data);
+        arena.reset();
+        if (ok) {
+            std::printf("prefix of %zu bytes parsed: %s\n", length, prefix.c_str());
+        }
+        CHECK(!ok);
+    }
+
+    FLStudioData data;
+    CHECK(FLParser::parse(json.data(), json.size(), arena, data));
+    CHECK(data.plugin == "Pro-Q \"3\" \xC3\xA9\xF0\x9F\x8E\xB9");
+    arena.reset();
+
+    // Unterminated strings, including one ending in a backslash
+    CHECK(!readOnlyString(arena, R"({"s":"abc)").ok);
+    CHECK(!readOnlyString(arena, "{\"s\":\"abc\\").ok);
+    CHECK(!readOnlyString(arena, "{\"s\":\"abc\\\"").ok);
+    FlatJsonReader reader("{\"s", 3);
+    std::string_view key;
+    CHECK(!reader.nextKey(key));
+    CHECK(reader.failed());
+}
+
+void checkSkipping(TickArena& arena) {
+    const char* json = R"({"before":1,"nested":{"x":[1,2,{"y":"]}\"{"}],"z":{}},"list":[[],[[]]],)"
+                       R"("flag":true,"none":null,"neg":-2.5e1,"after":"kept"})";
+    FlatJsonReader reader(json, std::strlen(json));
+    std::string_view key;
+    std::vector<std::string> keys;
+    std::string_view after;
+    while (reader.nextKey(key)) {
+        keys.emplace_back(key);
+        if (key == "after") {
+            CHECK(reader.readString(arena, after));
+        } else {
+            CHECK(reader.skipValue());
+        }
+    }
+    CHECK(!reader.failed());
+    CHECK((keys == std::vector<std::string>{"before", "nested", "list", "flag", "none", "neg", "after"}));
+    CHECK(after == "kept");
+    arena.reset();
+
+    // readRaw hands back a nested object for a reader of its own
+    const char* outer = R"({"data":{"evt":"READY","v":1},"cmd":"DISPATCH"})";
+    FlatJsonReader top(outer, std::strlen(outer));
+    std::string_view raw;
+    CHECK(top.nextKey(key) && key == "data" && top.readRaw(raw));
+    CHECK(raw == R"({"evt":"READY","v":1})");
+    CHECK(top.nextKey(key) && key == "cmd");
+
+    // A string where a number was expected is skipped, and reading carries on
+    const char* mixed = R"({"bpm":"fast","state":"Recording"})";
+    FLStudioData data;
+    CHECK(FLParser::parse(mixed, std::strlen(mixed), arena, data));
+    CHECK(data.bpm == FLStudioData().bpm);
+    CHECK(data.state == PresenceState::Recording);
+    arena.reset();
+}
+
+void checkWriteTime(TickArena& arena) {
+    // round(time.time(), 3) as json.dump writes it, for every millisecond
+    long long seconds = 1800000000;
+    int wrong = 0;
+    for (int ms = 0; ms < 1000; ms++) {
+        char json[96];
+        std::snprintf(json, sizeof(json), "{\"write_time\":%.17g}", static_cast<double>(seconds) + ms / 1000.0);
+        FLStudioData data;
+        CHECK(FLParser::parse(json, std::strlen(json), arena, data));
+        if (data.writeTimeMs != seconds * 1000 + ms && wrong++ < 5) {
+            std::printf("%s read as %lld\n", json, data.writeTimeMs);
+        }
+    }
+    CHECK(wrong == 0);
+
+    const char* cases[][2] = {
+        {R"({"write_time":1800000000})", "1800000000000"},
+        {R"({"write_time":1800000000.5})", "1800000000500"},
+        {R"({"write_time":1.8000000001234e9})", "1800000000123"},
+        {R"({"write_time":0})", "0"},
+    };
+    for (const auto& item : cases) {
+        FLStudioData data;
+        CHECK(FLParser::parse(item[0], std::strlen(item[0]), arena, data));
+        CHECK(std::to_string(data.writeTimeMs) == item[1]);
+    }
+    arena.reset();
+}
+
+} // namespace
+
+int main() {
+    TickArena arena;
+    checkEscapes(arena);
+    checkLoneSurrogates(arena);
+    checkTruncation(arena);
+    checkSkipping(arena);
+    checkWriteTime(arena);
+    return test::result();
+}
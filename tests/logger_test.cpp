@@ -0,0 +1,199 @@
+// The logger's lock-free ring under several producers, and per-site repeat
+// suppression. Worth running under -fsanitize=thread as well.
+#include "test_support.h"
+#include "logger.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+const int PRODUCERS = 4;
+const int MESSAGES_PER_PRODUCER = 20000;
+
+// Points stdout at a file while alive; the drain thread writes there
+class CapturedOutput {
+    private:
+        test::TempDir m_dir;
+        int m_saved;
+
+    public:
+        CapturedOutput() {
+            std::fflush(stdout);
+            m_saved = dup(STDOUT_FILENO);
+            int file = open(m_dir.file("out").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+            dup2(file, STDOUT_FILENO);
+            close(file);
+        }
+
+        ~CapturedOutput() {
+            restore();
+        }
+
+        void restore() {
+            if (m_saved < 0) {
+                return;
+            }
+            std::fflush(stdout);
+            dup2(m_saved, STDOUT_FILENO);
+            close(m_saved);
+            m_saved = -1;
+        }
+
+        std::vector<std::string> lines() {
+            restore();
+            std::vector<std::string> result;
+            FILE* file = std::fopen(m_dir.file("out").c_str(), "r");
+            char line[1024];
+            while (file && std::fgets(line, sizeof(line), file)) {
+                std::string text(line);
+                if (!text.empty() && text.back() == '\n') {
+                    text.pop_back();
+                }
+                result.push_back(text);
+            }
+            if (file) {
+                std::fclose(file);
+            }
+            return result;
+        }
+};
+
+// The message part of "hh:mm:ss.mmm LEVEL message"
+std::string messageOf(const std::string& line) {
+    return line.size() > 19 ? line.substr(19) : "";
+}
+
+void produce(int producer) {
+    for (int i = 0; i < MESSAGES_PER_PRODUCER; i++) {
+        LOG_INFO("producer {} message {}", producer, i);
+    }
+}
+
+// Every message is written or counted as dropped; none is torn or duplicated
+void checkProducers() {
+    CapturedOutput output;
+    Logger::start(LogLevel::Debug);
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < PRODUCERS; producer++) {
+        producers.emplace_back(produce, producer);
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+    Logger::stop();
+
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+    int last[PRODUCERS];
+    for (int& index : last) {
+        index = -1;
+    }
+    bool ordered = true;
+    bool wellFormed = true;
+    for (const std::string& line : output.lines()) {
+        int producer;
+        int index;
+        unsigned long long count;
+        if (std::sscanf(messageOf(line).c_str(), "producer %d message %d", &producer, &index) == 2 &&
+            producer >= 0 && producer < PRODUCERS) {
+            // Each producer's messages come out in the order it logged them
+            ordered = ordered && index > last[producer];
+            last[producer] = index;
+            written++;
+        } else if (std::sscanf(line.c_str(), "%llu log messages dropped", &count) == 1) {
+            dropped += count;
+        } else {
+            wellFormed = false;
+            std::fprintf(stderr, "unexpected line: %s\n", line.c_str());
+        }
+    }
+    CHECK(ordered);
+    CHECK(wellFormed);
+    CHECK(written + dropped == static_cast<uint64_t>(PRODUCERS) * MESSAGES_PER_PRODUCER);
+    CHECK(written > 0);
+    std::printf("%d producers: %llu written, %llu dropped\n", PRODUCERS,
+                static_cast<unsigned long long>(written), static_cast<unsigned long long>(dropped));
+}
+
+void logTick(int value) {
+    LOG_INFO("tick {}", value);
+}
+
+void logOther() {
+    LOG_INFO("something else");
+}
+
+// Identical messages from one site fold into a count, reported before the site's next message
+void checkSuppression() {
+    CapturedOutput output;
+    Logger::start(LogLevel::Debug);
+    for (int i = 0; i < 5; i++) {
+        logTick(1);
+    }
+    // Up to REPEAT_GAP other messages in between don't end the run
+    logOther();
+    logTick(1);
+    logTick(2);
+    logTick(2);
+    Logger::stop();
+    // Pending repeats of the last message are only reported when the site logs again
+    Logger::start(LogLevel::Debug);
+    logTick(3);
+    Logger::stop();
+
+    std::vector<std::string> messages;
+    for (const std::string& line : output.lines()) {
+        messages.push_back(messageOf(line));
+    }
+    std::vector<std::string> expected = {
+        "tick 1",
+        "something else",
+        "(previous message from this call site repeated 5 more times)",
+        "tick 2",
+        "(previous message from this call site repeated 1 more times)",
+        "tick 3",
+    };
+    CHECK(messages == expected);
+    if (messages != expected) {
+        for (const std::string& message : messages) {
+            std::fprintf(stderr, "  %s\n", message.c_str());
+        }
+    }
+}
+
+// Text past a record's payload is cut, and the line says so
+void checkTruncation() {
+    CapturedOutput output;
+    Logger::start(LogLevel::Debug);
+    std::string longText(2 * LogRecord::PAYLOAD_SIZE, 'x');
+    LOG_INFO("long {}", longText);
+    // Two-byte characters, one of which straddles the payload's end
+    std::string accents;
+    while (accents.size() < 2 * LogRecord::PAYLOAD_SIZE) {
+        accents += "\xC3\xA9";
+    }
+    LOG_INFO("accents {}", accents);
+    Logger::stop();
+
+    std::vector<std::string> lines = output.lines();
+    CHECK(lines.size() == 2);
+    for (const std::string& line : lines) {
+        CHECK(line.size() < longText.size());
+        size_t marker = line.rfind(" [truncated]");
+        CHECK(marker != std::string::npos);
+        // The character before the marker is whole
+        CHECK(marker > 0 && (static_cast<unsigned char>(line[marker - 1]) & 0xC0) != 0xC0);
+    }
+}
+
+} // namespace
+
+int main() {
+    checkProducers();
+    checkSuppression();
+    checkTruncation();
+    return test::result();
+}
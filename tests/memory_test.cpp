@@ -0,0 +1,105 @@
+// Steady-state update() ticks must not touch the heap (MEMORY_STATS)
+#include "test_support.h"
+#include "app_state.h"
+#include "clock.h"
+#include "logger.h"
+#include "memory_stats.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// Connection setup and first-use buffer growth happen in these
+const int WARMUP_TICKS = 50;
+const int STEADY_TICKS = 500;
+
+// Another presence change every this many ticks in the steady state
+const int CHANGE_EVERY_TICKS = 25;
+
+// Stored through so the compiler can't drop a new/delete pair
+int* volatile g_sink;
+
+void checkCounting() {
+    CHECK(MemoryStats::hookInstalled());
+
+    uint64_t before = MemoryStats::threadAllocations();
+    g_sink = new int(1);
+    CHECK(MemoryStats::threadAllocations() == before + 1);
+    delete g_sink;
+
+    // Other threads' allocations aren't the update thread's
+    std::atomic<bool> go(false);
+    std::thread other([&go] {
+        while (!go.load()) {
+            std::this_thread::yield();
+        }
+        g_sink = new int(2);
+        delete g_sink;
+    });
+    before = MemoryStats::threadAllocations();
+    go.store(true);
+    other.join();
+    CHECK(MemoryStats::threadAllocations() == before);
+}
+
+} // namespace
+
+int main() {
+    checkCounting();
+
+    test::TempDir dir;
+    test::FakeDiscord discord(dir.path());
+    test::FlStudioStub flStudio;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+    Logger::start(LogLevel::Warn);
+
+    SimulatedClock clock(1800000000000LL);
+    std::string statePath = dir.file("fl_studio_state.json");
+    test::writeStateFile(statePath, "Composing", 120, "", clock.unixTimeMs());
+    flStudio.start();
+
+    AppSettings settings;
+    settings.stateFilePath = statePath;
+    settings.memoryStats = true;
+    settings.audioSafe = false;
+    {
+        AppState app(clock);
+        app.initialize(settings);
+        app.startMonitoring();
+
+        for (int tick = 0; tick < WARMUP_TICKS; tick++) {
+            app.update();
+            discord.settle();
+            app.waitForNextTick();
+        }
+        CHECK(app.getStatus().discordConnected);
+        CHECK(app.getStatus().flStudioRunning);
+        size_t activitiesBefore = discord.activities().size();
+
+        int allocatingTicks = 0;
+        for (int tick = 0; tick < STEADY_TICKS; tick++) {
+            if (tick % CHANGE_EVERY_TICKS == 0) {
+                const char* state = (tick / CHANGE_EVERY_TICKS) % 2 ? "Playing" : "Composing";
+                test::writeStateFile(statePath, state, 120 + tick % 7, tick % 2 ? "Serum" : "", clock.unixTimeMs());
+            }
+
+            uint64_t before = MemoryStats::threadAllocations();
+            app.update();
+            uint64_t allocations = MemoryStats::threadAllocations() - before;
+            if (allocations > 0 && allocatingTicks++ < 5) {
+                std::fprintf(stderr, "steady-state tick %d allocated %llu times\n",
+                             tick, static_cast<unsigned long long>(allocations));
+            }
+            discord.settle();
+            app.waitForNextTick();
+        }
+        CHECK(allocatingTicks == 0);
+        // The changes above really went out
+        CHECK(discord.activities().size() > activitiesBefore);
+
+        app.requestExit();
+        app.update();
+    }
+    Logger::stop();
+    return test::result();
+}
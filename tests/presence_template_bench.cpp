@@ -0,0 +1,91 @@
+// Cost of rendering the activity text through compiled templates, against the
+// fixed formatting the templates replaced
+#include "test_support.h"
+#include "json_lite.h"
+#include "presence_template.h"
+
+namespace {
+
+const int RENDERS = 2000000;
+
+// Defeats dead-code elimination of the rendered sizes
+volatile size_t g_sink;
+
+// The fixed "Composing • Serum" / "128 BPM" text, as built before templates
+void renderFixed(const PresenceFields& fields, ArenaWriter& out) {
+    out.appendInt(fields.bpm);
+    out += std::string_view(" BPM");
+    out += presenceStateName(fields.state);
+    if (!fields.plugin.empty()) {
+        out += std::string_view(" • ");
+        appendJsonEscaped(out, fields.plugin);
+    }
+}
+
+void renderTemplates(const PresenceFormat& format, const PresenceFields& fields, ArenaWriter& out) {
+    format.state.render(fields, out);
+    format.details.render(fields, out);
+}
+
+std::string rendered(TickArena& arena, void (*render)(const PresenceFormat&, const PresenceFields&, ArenaWriter&),
+                     const PresenceFormat& format, const PresenceFields& fields) {
+    ArenaWriter out(arena);
+    render(format, fields, out);
+    std::string text(out.data(), out.size());
+    arena.reset();
+    return text;
+}
+
+template <typename Render>
+double nsPerRender(TickArena& arena, PresenceFields fields, Render render) {
+    size_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RENDERS; i++) {
+        fields.bpm = 100 + (i & 63);
+        ArenaWriter out(arena);
+        render(fields, out);
+        total += out.size();
+        arena.reset();
+    }
+    double ns = test::msSince(start) * 1e6 / RENDERS;
+    g_sink = total;
+    return ns;
+}
+
+} // namespace
+
+int main() {
+    TickArena arena;
+    PresenceFormat defaults;
+    PresenceFormat custom;
+    std::string error;
+    CHECK(custom.details.compile("[{project} — ]{state}[ • {plugin}]", error));
+    CHECK(custom.state.compile("{bpm} BPM[ · {cpu}% CPU][ · {memory} MB]", error));
+
+    PresenceFields fields = {PresenceState::Composing, 140, "FabFilter Pro-Q 3", "Track \"One\"", 37, 812};
+    PresenceFields noPlugin = {PresenceState::Recording, 90, "", "", -1, 0};
+    PresenceFields quoted = {PresenceState::Listening, 128, "Plugin \"X\" \\ v2", "", -1, 0};
+
+    // The default templates render exactly what the fixed text did
+    auto fixed = [](const PresenceFormat&, const PresenceFields& f, ArenaWriter& out) { renderFixed(f, out); };
+    for (const PresenceFields& sample : {fields, noPlugin, quoted}) {
+        CHECK(rendered(arena, renderTemplates, defaults, sample) == rendered(arena, fixed, defaults, sample));
+    }
+    CHECK(rendered(arena, renderTemplates, custom, fields) ==
+          "140 BPM · 37% CPU · 812 MBTrack \\\"One\\\" — Composing • FabFilter Pro-Q 3");
+    CHECK(rendered(arena, renderTemplates, custom, noPlugin) == "90 BPMRecording");
+
+    double fixedNs = nsPerRender(arena, fields, [](const PresenceFields& f, ArenaWriter& out) { renderFixed(f, out); });
+    double defaultNs = nsPerRender(arena, fields, [&](const PresenceFields& f, ArenaWriter& out) {
+        renderTemplates(defaults, f, out);
+    });
+    double customNs = nsPerRender(arena, fields, [&](const PresenceFields& f, ArenaWriter& out) {
+        renderTemplates(custom, f, out);
+    });
+    CHECK(arena.overflowCount() == 0);
+
+    std::printf("fixed text                 %6.1f ns\n", fixedNs);
+    std::printf("default templates          %6.1f ns\n", defaultNs);
+    std::printf("project, CPU and memory    %6.1f ns\n", customNs);
+    return test::result();
+}
@@ -0,0 +1,103 @@
+// One process scan's worth of name matching: 5,000 names through the compiled
+// matcher against the lowercase-and-compare chain it replaced
+#include "test_support.h"
+#include "process_matcher.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+const int NAMES = 5000;
+const int SCANS = 500;
+
+// Typical of a desktop running FL Studio under Wine; /proc/<pid>/comm keeps 15 bytes
+const char* const COMMON_NAMES[] = {
+    "systemd", "kworker/3:1-events", "bash", "pipewire", "pipewire-pulse", "wireplumber", "Xwayland",
+    "gnome-shell", "firefox", "Isolated Web Co", "chrome", "code", "node", "python3", "sshd",
+    "dbus-daemon", "wineserver", "winedevice.exe", "services.exe", "explorer.exe", "svchost.exe",
+    "RuntimeBroker.exe", "flatpak-session", "fluidsynth", "flameshot", "FLRP", "audacity", "Discord",
+    "rcu_sched", "ksoftirqd/0"
+};
+
+const char* const FL_STUDIO_NAMES[] = {
+    "FL64.exe", "fl64", "FL.exe", "FL32.EXE", "FLStudio", "FL Studio 21.ex", "flstudio.exe"
+};
+
+volatile size_t g_sink;
+
+// The name check before ProcessMatcher
+bool comparisonChain(std::string_view name) {
+    char lower[260];
+    if (name.size() > sizeof(lower)) {
+        return false;
+    }
+    std::transform(name.begin(), name.end(), lower, ::tolower);
+    std::string_view processName(lower, name.size());
+
+    return processName == "fl64.exe" ||
+           processName == "fl64" ||
+           processName == "fl32.exe" ||
+           processName == "fl32" ||
+           processName == "fl.exe" ||
+           processName == "fl" ||
+           processName == "flstudio.exe" ||
+           processName == "flstudio" ||
+           (processName.substr(0, 2) == "fl" && processName.find("studio") != std::string_view::npos);
+}
+
+std::vector<std::string> processNames() {
+    std::mt19937 random(7);
+    std::vector<std::string> names;
+    names.reserve(NAMES);
+    const size_t common = sizeof(COMMON_NAMES) / sizeof(COMMON_NAMES[0]);
+    const size_t flStudio = sizeof(FL_STUDIO_NAMES) / sizeof(FL_STUDIO_NAMES[0]);
+    for (int i = 0; i < NAMES; i++) {
+        if (i % 500 == 0) {
+            names.push_back(FL_STUDIO_NAMES[(i / 500) % flStudio]);
+            continue;
+        }
+        std::string name = COMMON_NAMES[random() % common];
+        if (random() % 3 == 0) {
+            name += std::to_string(random() % 100);
+        }
+        name.resize(std::min<size_t>(name.size(), 15));
+        names.push_back(name);
+    }
+    return names;
+}
+
+template <typename Match>
+double usPerScan(const std::vector<std::string>& names, Match match) {
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int scan = 0; scan < SCANS; scan++) {
+        for (const std::string& name : names) {
+            found += match(name);
+        }
+    }
+    double us = test::msSince(start) * 1000 / SCANS;
+    g_sink = found;
+    return us;
+}
+
+} // namespace
+
+int main() {
+    ProcessMatcher matcher;
+    std::vector<std::string> names = processNames();
+
+    // The default patterns accept exactly what the chain did
+    size_t matched = 0;
+    for (const std::string& name : names) {
+        bool expected = comparisonChain(name);
+        CHECK(matcher.matches(name) == expected);
+        matched += expected;
+    }
+    CHECK(matched == NAMES / 500);
+
+    double chainUs = usPerScan(names, comparisonChain);
+    double matcherUs = usPerScan(names, [&matcher](std::string_view name) { return matcher.matches(name); });
+    std::printf("%d names, %zu FL Studio: comparison chain %.1f us, matcher %.1f us (%.1fx)\n",
+                NAMES, matched, chainUs, matcherUs, chainUs / matcherUs);
+    return test::result();
+}
@@ -0,0 +1,160 @@
+// FL Studio's CPU and memory readings: the stat fields parse whatever the
+// process is called, a busy process reads a full core and an idle one none,
+// and the sampler lets go once the process exits
+#include "test_support.h"
+#include "process_sampler.h"
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+// Parsing from the first ')' would take "R 9 9 ..." for the fields after the name
+const char CHILD_NAME[] = "x) R 9 9 9 9 9";
+const int SAMPLE_INTERVAL_MS = 500;
+
+// A renamed child that spins or sleeps until killed
+pid_t startChild(bool busy) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        prctl(PR_SET_NAME, CHILD_NAME);
+        if (busy) {
+            volatile unsigned long spin = 0;
+            for (;;) {
+                spin++;
+            }
+        }
+        for (;;) {
+            pause();
+        }
+    }
+
+    std::string commPath = "/proc/" + std::to_string(pid) + "/comm";
+    auto start = std::chrono::steady_clock::now();
+    while (test::msSince(start) < 5000) {
+        char name[32] = {};
+        FILE* comm = std::fopen(commPath.c_str(), "r");
+        if (comm) {
+            size_t n = std::fread(name, 1, sizeof(name) - 1, comm);
+            std::fclose(comm);
+            if (n > 0 && std::strncmp(name, CHILD_NAME, sizeof(CHILD_NAME) - 1) == 0) {
+                return pid;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::fprintf(stderr, "child didn't rename itself\n");
+    std::abort();
+}
+
+void stopChild(pid_t pid) {
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+
+// Resident pages as statm reports them, in bytes
+uint64_t statmRssBytes(pid_t pid) {
+    std::string path = "/proc/" + std::to_string(pid) + "/statm";
+    FILE* statm = std::fopen(path.c_str(), "r");
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    if (!statm) {
+        return 0;
+    }
+    if (std::fscanf(statm, "%llu %llu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    std::fclose(statm);
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+// CPU use of pid over one sample interval
+int measureCpu(ProcessSampler& sampler) {
+    CHECK(sampler.sample(std::chrono::steady_clock::now()));
+    CHECK(sampler.usage().cpuPercent == -1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(SAMPLE_INTERVAL_MS));
+    CHECK(sampler.sample(std::chrono::steady_clock::now()));
+    return sampler.usage().cpuPercent;
+}
+
+void testFlStudioStub() {
+    test::FlStudioStub flStudio;
+    flStudio.start();
+    ProcessSampler sampler;
+    CHECK(sampler.attach(static_cast<uint32_t>(flStudio.pid())));
+    CHECK(sampler.pid() == static_cast<uint32_t>(flStudio.pid()));
+    CHECK(sampler.sample(std::chrono::steady_clock::now()));
+    CHECK(sampler.usage().rssBytes > 0);
+    CHECK(sampler.usage().rssBytes == statmRssBytes(flStudio.pid()));
+    flStudio.stop();
+}
+
+void testBusyChild() {
+    pid_t pid = startChild(true);
+    ProcessSampler sampler;
+    CHECK(sampler.attach(static_cast<uint32_t>(pid)));
+    int cpu = measureCpu(sampler);
+    std::printf("busy child: %d%% CPU\n", cpu);
+    // Clock ticks are coarse and the test shares the machine with the child
+    CHECK(cpu >= 70 && cpu <= 110);
+    stopChild(pid);
+}
+
+void testIdleChild() {
+    pid_t pid = startChild(false);
+    ProcessSampler sampler;
+    CHECK(sampler.attach(static_cast<uint32_t>(pid)));
+    int cpu = measureCpu(sampler);
+    std::printf("idle child: %d%% CPU\n", cpu);
+    CHECK(cpu >= 0 && cpu <= 5);
+    // Asleep, so its resident set holds still between the two reads
+    CHECK(sampler.usage().rssBytes > 0);
+    CHECK(sampler.usage().rssBytes == statmRssBytes(pid));
+    stopChild(pid);
+}
+
+void testExit() {
+    ProcessSampler sampler;
+    CHECK(!sampler.attach(0x7ffffffe));
+    CHECK(sampler.pid() == 0);
+    CHECK(!sampler.sample(std::chrono::steady_clock::now()));
+
+    // Exited but not yet reaped
+    pid_t pid = startChild(false);
+    CHECK(sampler.attach(static_cast<uint32_t>(pid)));
+    CHECK(sampler.sample(std::chrono::steady_clock::now()));
+    kill(pid, SIGKILL);
+    siginfo_t info;
+    CHECK(waitid(P_PID, static_cast<id_t>(pid), &info, WEXITED | WNOWAIT) == 0);
+    CHECK(!sampler.sample(std::chrono::steady_clock::now()));
+    CHECK(sampler.pid() == 0);
+    CHECK(sampler.usage() == ProcessUsage());
+    waitpid(pid, nullptr, 0);
+
+    // Reaped
+    pid = startChild(false);
+    CHECK(sampler.attach(static_cast<uint32_t>(pid)));
+    CHECK(measureCpu(sampler) >= 0);
+    stopChild(pid);
+    CHECK(!sampler.sample(std::chrono::steady_clock::now()));
+    CHECK(sampler.pid() == 0);
+    CHECK(sampler.usage() == ProcessUsage());
+    CHECK(!sampler.sample(std::chrono::steady_clock::now()));
+}
+
+} // namespace
+
+int main() {
+    testFlStudioStub();
+    testBusyChild();
+    testIdleChild();
+    testExit();
+    return test::result();
+}
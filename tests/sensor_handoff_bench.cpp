@@ -0,0 +1,133 @@
+// Latency from the sensor publishing a snapshot to the update thread holding it:
+// TripleBuffer + WakeEvent against a mutex and condition variable
+#include "test_support.h"
+#include "triple_buffer.h"
+#include "wake_event.h"
+#include <algorithm>
+#include <condition_variable>
+
+namespace {
+
+const int HANDOFFS = 2000;
+const int GAP_US = 200;     // Between publishes, so each one is waited for
+
+typedef std::chrono::steady_clock SteadyClock;
+
+struct Stamped {
+    uint64_t sequence;
+    SteadyClock::time_point publishedAt;
+};
+
+struct Result {
+    std::vector<double> latenciesUs;
+    uint64_t lastSequence;
+};
+
+void report(const char* name, Result& result) {
+    std::vector<double>& samples = result.latenciesUs;
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    CHECK(n > 0);
+    if (n == 0) {
+        return;
+    }
+    std::printf("%-26s n=%zu p50=%.1fus p99=%.1fus max=%.1fus\n", name, n,
+                samples[n / 2], samples[std::min(n - 1, n * 99 / 100)], samples[n - 1]);
+}
+
+Result lockFree() {
+    TripleBuffer<Stamped> buffer;
+    WakeEvent wake;
+    std::atomic<bool> done(false);
+    Result result;
+    result.latenciesUs.reserve(HANDOFFS);
+    result.lastSequence = 0;
+
+    std::thread producer([&] {
+        for (int i = 1; i <= HANDOFFS; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(GAP_US));
+            buffer.back().sequence = static_cast<uint64_t>(i);
+            buffer.back().publishedAt = SteadyClock::now();
+            buffer.publish();
+            wake.signal();
+        }
+        done.store(true);
+        wake.signal();
+    });
+
+    while (!done.load() || result.lastSequence < HANDOFFS) {
+        wake.wait(100);
+        while (buffer.update()) {
+            const Stamped& front = buffer.front();
+            result.latenciesUs.push_back(
+                std::chrono::duration<double, std::micro>(SteadyClock::now() - front.publishedAt).count());
+            result.lastSequence = front.sequence;
+        }
+    }
+    producer.join();
+    return result;
+}
+
+Result locked() {
+    std::mutex mutex;
+    std::condition_variable changed;
+    Stamped shared = {0, SteadyClock::time_point()};
+    bool fresh = false;
+    Result result;
+    result.latenciesUs.reserve(HANDOFFS);
+    result.lastSequence = 0;
+
+    std::thread producer([&] {
+        for (int i = 1; i <= HANDOFFS; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(GAP_US));
+            std::lock_guard<std::mutex> lock(mutex);
+            shared.sequence = static_cast<uint64_t>(i);
+            shared.publishedAt = SteadyClock::now();
+            fresh = true;
+            changed.notify_one();
+        }
+    });
+
+    while (result.lastSequence < HANDOFFS) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::milliseconds(100), [&fresh] { return fresh; });
+        if (!fresh) {
+            continue;
+        }
+        Stamped taken = shared;
+        fresh = false;
+        lock.unlock();
+        result.latenciesUs.push_back(
+            std::chrono::duration<double, std::micro>(SteadyClock::now() - taken.publishedAt).count());
+        result.lastSequence = taken.sequence;
+    }
+    producer.join();
+    return result;
+}
+
+// What the update thread pays per tick when the sensor has nothing new
+void pollCost() {
+    TripleBuffer<Stamped> buffer;
+    const int polls = 10000000;
+    int updates = 0;
+    auto start = SteadyClock::now();
+    for (int i = 0; i < polls; i++) {
+        updates += buffer.update() ? 1 : 0;
+    }
+    double ms = test::msSince(start);
+    CHECK(updates == 0);
+    std::printf("%-26s %.2f ns per call\n", "update() with nothing new", ms * 1e6 / polls);
+}
+
+} // namespace
+
+int main() {
+    Result tripleBuffer = lockFree();
+    Result mutexed = locked();
+    CHECK(tripleBuffer.lastSequence == HANDOFFS);
+    CHECK(mutexed.lastSequence == HANDOFFS);
+    report("TripleBuffer + WakeEvent", tripleBuffer);
+    report("mutex + condition_variable", mutexed);
+    pollCost();
+    return test::result();
+}
@@ -0,0 +1,157 @@
+// Hours of FL Studio sessions replayed under a SimulatedClock against a fake Discord
+#include "test_support.h"
+#include "app_state.h"
+#include "clock.h"
+#include "logger.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const int HOURS = 3;
+
+// Each hour: FL Studio opens a minute in, and closes after a 40-minute session
+const long long HOUR_MS = 3600000;
+const long long LAUNCH_MS = 60000;
+const int SESSION_MINUTES = 40;
+const long long CLOSE_MS = LAUNCH_MS + (SESSION_MINUTES + 1) * 60000LL;
+
+struct Event {
+    long long atMs;
+    enum Kind { Write, Launch, Close } kind;
+    const char* state;
+    int bpm;
+    const char* plugin;
+};
+
+std::vector<Event> sessions() {
+    std::vector<Event> events;
+    for (int hour = 0; hour < HOURS; hour++) {
+        long long base = hour * HOUR_MS;
+        events.push_back({base + LAUNCH_MS, Event::Launch, "Idle", 120, ""});
+        for (int minute = 0; minute < SESSION_MINUTES; minute++) {
+            long long at = base + LAUNCH_MS + minute * 60000LL + 5000;
+            const char* state = minute % 10 == 7 ? "Recording" : minute % 5 == 3 ? "Listening" : "Composing";
+            int bpm = 120 + (minute % 4) * 2;
+            events.push_back({at, Event::Write, state, bpm, ""});
+            // Nudged again inside the BPM settle window; without a state change only the second value goes out
+            events.push_back({at + 700, Event::Write, state, bpm + 1, ""});
+            events.push_back({at + 20000, Event::Write, state, bpm + 1, minute % 3 ? "Serum" : "Sytrus"});
+        }
+        events.push_back({base + CLOSE_MS, Event::Close, nullptr, 0, nullptr});
+    }
+    return events;
+}
+
+bool isClear(const std::string& body) {
+    return body.find("\"activity\":{") == std::string::npos;
+}
+
+// The activity itself, without the nonce that makes every frame unique
+std::string activityOf(const std::string& body) {
+    size_t start = body.find("\"activity\":");
+    return start == std::string::npos ? "" : body.substr(start);
+}
+
+long long elapsedMs(const SimulatedClock& clock) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(clock.elapsed()).count();
+}
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    test::FakeDiscord discord(dir.path());
+    test::FlStudioStub flStudio;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+    Logger::start(LogLevel::Warn);
+
+    SimulatedClock clock(1800000000000LL);
+    std::string statePath = dir.file("fl_studio_state.json");
+    test::writeStateFile(statePath, "Idle", 120, "", clock.unixTimeMs());
+
+    AppSettings settings;
+    settings.stateFilePath = statePath;
+    settings.audioSafe = false;
+    AppState app(clock);
+    app.initialize(settings);
+    app.startMonitoring();
+
+    std::vector<Event> events = sessions();
+    size_t next = 0;
+    uint64_t ticks = 0;
+    size_t seen = 0;
+    long long launchedAt = -1;
+    long long closedAt = -1;
+    long long slowestLaunchMs = 0;
+    long long slowestCloseMs = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (elapsedMs(clock) < HOURS * HOUR_MS) {
+        while (next < events.size() && events[next].atMs <= elapsedMs(clock)) {
+            const Event& event = events[next++];
+            if (event.kind == Event::Launch) {
+                flStudio.start();
+                launchedAt = event.atMs;
+            } else if (event.kind == Event::Close) {
+                flStudio.stop();
+                closedAt = event.atMs;
+            }
+            if (event.state) {
+                test::writeStateFile(statePath, event.state, event.bpm, event.plugin, clock.unixTimeMs());
+            }
+        }
+        app.update();
+        discord.settle();
+        ticks++;
+
+        std::vector<std::string> activities = discord.activities();
+        for (; seen < activities.size(); seen++) {
+            if (launchedAt >= 0 && !isClear(activities[seen])) {
+                slowestLaunchMs = std::max(slowestLaunchMs, elapsedMs(clock) - launchedAt);
+                launchedAt = -1;
+            } else if (closedAt >= 0 && isClear(activities[seen])) {
+                slowestCloseMs = std::max(slowestCloseMs, elapsedMs(clock) - closedAt);
+                closedAt = -1;
+            }
+        }
+        app.waitForNextTick();
+    }
+    double wallMs = test::msSince(start);
+    AppState::Status status = app.getStatus();
+    app.requestExit();
+    app.update();
+    discord.settle();
+
+    std::vector<std::string> activities = discord.activities();
+    size_t clears = 0;
+    size_t repeats = 0;
+    bool recorded = false;
+    for (size_t i = 0; i < activities.size(); i++) {
+        clears += isClear(activities[i]);
+        recorded = recorded || activities[i].find("Recording") != std::string::npos;
+        if (i > 0 && !isClear(activities[i]) && activityOf(activities[i]) == activityOf(activities[i - 1])) {
+            repeats++;
+        }
+    }
+
+    // One connection for every session; each close cleared the presence (and exit once more)
+    CHECK(discord.connections() == 1);
+    CHECK(clears == HOURS + 1);
+    CHECK(recorded);
+    // Coalescing: nothing sent twice, BPM nudges folded together
+    CHECK(repeats == 0);
+    CHECK(status.updatesMerged > 0);
+    CHECK(activities.size() < 4 * HOURS * SESSION_MINUTES);
+    // Times from the scripted event, which the loop only acts on at its next tick:
+    // a launch is seen within the absent back-off, a close within an idle poll
+    CHECK(launchedAt == -1 && slowestLaunchMs <= settings.pollPolicy.absentMaxMs + settings.pollPolicy.activeMs);
+    CHECK(closedAt == -1 && slowestCloseMs <= settings.pollPolicy.idleMs);
+
+    std::printf("%d h simulated in %.0f ms: %llu ticks, %zu activities (%zu clears), %llu merged, "
+                "launch seen after %lld ms at most, close after %lld ms\n",
+                HOURS, wallMs, static_cast<unsigned long long>(ticks), activities.size(), clears,
+                static_cast<unsigned long long>(status.updatesMerged), slowestLaunchMs, slowestCloseMs);
+    Logger::stop();
+    return test::result();
+}
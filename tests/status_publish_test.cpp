@@ -0,0 +1,85 @@
+// The published status changes when something in it does, and the wakeup
+// counters on their own refresh it at most once a second
+#include "test_support.h"
+#include "app_state.h"
+#include "clock.h"
+#include "logger.h"
+#include <cstdlib>
+
+namespace {
+
+const int TICKS = 200;
+
+} // namespace
+
+int main() {
+    test::TempDir dir;
+    test::FakeDiscord discord(dir.path());
+    test::FlStudioStub flStudio;
+    setenv("XDG_RUNTIME_DIR", dir.path().c_str(), 1);
+    Logger::start(LogLevel::Warn);
+
+    // Equality ignores the counters, so they can't force a publish by themselves
+    AppState::Status a;
+    AppState::Status b;
+    b.wakeups.ticks[0] = 1;
+    CHECK(a == b);
+
+    SimulatedClock clock(1800000000000LL);
+    std::string statePath = dir.file("fl_studio_state.json");
+    test::writeStateFile(statePath, "Composing", 120, "", clock.unixTimeMs());
+    flStudio.start();
+
+    AppSettings settings;
+    settings.stateFilePath = statePath;
+    settings.audioSafe = false;
+    // FL Studio's CPU and memory samples would change the status on their own
+    settings.pollPolicy.sampleMs = 0;
+    {
+        AppState app(clock);
+        app.initialize(settings);
+        app.startMonitoring();
+        for (int tick = 0; tick < 10; tick++) {
+            app.update();
+            discord.settle();
+            app.waitForNextTick();
+        }
+
+        // Composing polls every activeMs (500 ms), so two ticks share each refresh
+        AppState::Status previous = app.getStatus();
+        Clock::TimePoint changedAt;
+        int refreshes = 0;
+        bool tooSoon = false;
+        for (int tick = 0; tick < TICKS; tick++) {
+            app.update();
+            discord.settle();
+            AppState::Status status = app.getStatus();
+            if (status.wakeups != previous.wakeups) {
+                tooSoon = tooSoon || (refreshes > 0 && clock.now() - changedAt < std::chrono::milliseconds(1000));
+                changedAt = clock.now();
+                refreshes++;
+            }
+            // Nothing else moves while FL Studio sits in the same state
+            CHECK(status == previous);
+            previous = status;
+            app.waitForNextTick();
+        }
+        CHECK(!tooSoon);
+        CHECK(refreshes >= TICKS / 2 - 1 && refreshes <= TICKS / 2 + 1);
+        CHECK(previous.wakeups.perHour(PollMode::Active) > 0);
+
+        // A real change still goes out on its own tick
+        test::writeStateFile(statePath, "Listening", 120, "", clock.unixTimeMs());
+        for (int tick = 0; tick < 4 && app.getStatus().activity.state != PresenceState::Listening; tick++) {
+            app.waitForNextTick();
+            app.update();
+            discord.settle();
+        }
+        CHECK(app.getStatus().activity.state == PresenceState::Listening);
+
+        app.requestExit();
+        app.update();
+    }
+    Logger::stop();
+    return test::result();
+}
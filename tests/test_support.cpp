@@ -0,0 +1,324 @@
+#include "test_support.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <ftw.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef FLRP_TEST_FL_STUB
+#error "FLRP_TEST_FL_STUB must name the FL Studio stand-in executable"
+#endif
+
+namespace test {
+
+namespace {
+
+int g_failures = 0;
+
+// Frames must be answered within this much real time, or settle() gives up
+const int SETTLE_TIMEOUT_MS = 5000;
+
+int removeEntry(const char* path, const struct stat*, int, struct FTW*) {
+    return remove(path);
+}
+
+bool readAll(int fd, int stopFd, void* buffer, size_t length) {
+    char* out = static_cast<char*>(buffer);
+    while (length > 0) {
+        pollfd fds[2] = {{fd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (fds[1].revents != 0) {
+            return false;
+        }
+        ssize_t n = read(fd, out, length);
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void sendFrame(int fd, uint32_t opcode, const std::string& body) {
+    uint32_t header[2] = {opcode, static_cast<uint32_t>(body.size())};
+    std::string frame(reinterpret_cast<const char*>(header), sizeof(header));
+    frame += body;
+    ssize_t ignored = write(fd, frame.data(), frame.size());
+    (void)ignored;
+}
+
+// "nonce":"<value>" from a request body
+std::string nonceOf(const std::string& body) {
+    size_t start = body.find("\"nonce\":\"");
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += 9;
+    return body.substr(start, body.find('"', start) - start);
+}
+
+} // namespace
+
+bool check(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+        g_failures++;
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    }
+    return ok;
+}
+
+int result() {
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+TempDir::TempDir() {
+    const char* base = std::getenv("TMPDIR");
+    std::string pattern = std::string(base && *base ? base : "/tmp") + "/flrp-test-XXXXXX";
+    if (!mkdtemp(&pattern[0])) {
+        std::perror("mkdtemp");
+        std::abort();
+    }
+    m_path = pattern;
+}
+
+TempDir::~TempDir() {
+    nftw(m_path.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+void writeStateFile(const std::string& path, const char* state, int bpm, const char* plugin, long long writeTimeMs) {
+    std::string temp = path + ".tmp";
+    FILE* file = std::fopen(temp.c_str(), "w");
+    if (!file) {
+        std::perror("fopen");
+        std::abort();
+    }
+    std::fprintf(file, "{\"state\":\"%s\",\"bpm\":%d.0,\"plugin\":\"%s\",\"timestamp\":1,"
+                 "\"project_name\":\"Song\",\"write_time\":%lld.%03lld}",
+                 state, bpm, plugin, writeTimeMs / 1000, writeTimeMs % 1000);
+    std::fclose(file);
+    std::rename(temp.c_str(), path.c_str());
+}
+
+FakeDiscord::FakeDiscord(const std::string& dir, Mode mode, int index)
+    : m_path(dir + "/discord-ipc-" + std::to_string(index))
+    , m_listener(-1)
+    , m_client(-1)
+    , m_mode(mode)
+    , m_readyDelayMs(0)
+    , m_busy(false)
+    , m_connections(0) {
+    if (pipe2(m_stopPipe, O_CLOEXEC) != 0) {
+        std::perror("pipe2");
+        std::abort();
+    }
+
+    m_listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, m_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(m_path.c_str());
+    if (bind(m_listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(m_listener, 4) != 0) {
+        std::perror("FakeDiscord: bind");
+        std::abort();
+    }
+    m_thread = std::thread(&FakeDiscord::run, this);
+}
+
+FakeDiscord::~FakeDiscord() {
+    char stop = 1;
+    ssize_t ignored = write(m_stopPipe[1], &stop, 1);
+    (void)ignored;
+    m_thread.join();
+    close(m_stopPipe[0]);
+    close(m_stopPipe[1]);
+    close(m_listener);
+    unlink(m_path.c_str());
+}
+
+void FakeDiscord::run() {
+    for (;;) {
+        pollfd fds[2] = {{m_listener, POLLIN, 0}, {m_stopPipe[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents != 0) {
+            return;
+        }
+        int client = accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        m_connections++;
+        m_client.store(client);
+        serve(client);
+        m_client.store(-1);
+        close(client);
+    }
+}
+
+void FakeDiscord::serve(int client) {
+    for (;;) {
+        uint32_t header[2];
+        if (!readAll(client, m_stopPipe[0], header, sizeof(header))) {
+            return;
+        }
+        // The body is still unread here, so settle() can't miss the frame in between
+        m_busy.store(true);
+        std::string body(header[1], '\0');
+        if (header[1] > 0 && !readAll(client, m_stopPipe[0], &body[0], header[1])) {
+            m_busy.store(false);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_framesMutex);
+            m_frames.push_back(Frame{header[0], body});
+        }
+
+        Mode mode = m_mode.load();
+        if (header[0] == 0 && mode == Mode::CloseOnHandshake) {
+            m_busy.store(false);
+            return;
+        }
+        if (header[0] == 0 && mode == Mode::RejectHandshake) {
+            sendFrame(client, 1, "{\"cmd\":\"DISPATCH\",\"evt\":\"ERROR\",\"nonce\":null,"
+                                 "\"data\":{\"code\":4000,\"message\":\"Invalid Client ID\"}}");
+        } else if (header[0] == 0) {
+            if (mode == Mode::SlowReady) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_readyDelayMs.load()));
+            }
+            if (mode != Mode::StallHandshake) {
+                sendFrame(client, 1, "{\"cmd\":\"DISPATCH\",\"evt\":\"READY\",\"data\":{\"v\":1}}");
+            }
+        } else if (header[0] == 3 && mode != Mode::StallResponses) {
+            sendFrame(client, 4, body);
+        } else if (header[0] == 1 && mode != Mode::StallResponses && mode != Mode::StallHandshake) {
+            sendFrame(client, 1, "{\"cmd\":\"SET_ACTIVITY\",\"nonce\":\"" + nonceOf(body) + "\",\"evt\":null,\"data\":{}}");
+        }
+        m_busy.store(false);
+    }
+}
+
+void FakeDiscord::settle() {
+    auto start = std::chrono::steady_clock::now();
+    while (msSince(start) < SETTLE_TIMEOUT_MS) {
+        pollfd pendingConnection = {m_listener, POLLIN, 0};
+        bool connecting = poll(&pendingConnection, 1, 0) > 0;
+
+        int client = m_client.load();
+        int pending = 0;
+        if (client >= 0) {
+            ioctl(client, FIONREAD, &pending);
+        }
+        if (!connecting && pending == 0 && !m_busy.load()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool FakeDiscord::waitForFrames(size_t count, int timeoutMs) {
+    auto start = std::chrono::steady_clock::now();
+    while (msSince(start) < timeoutMs) {
+        {
+            std::lock_guard<std::mutex> lock(m_framesMutex);
+            if (m_frames.size() >= count) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+std::vector<FakeDiscord::Frame> FakeDiscord::frames() const {
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    return m_frames;
+}
+
+std::vector<std::string> FakeDiscord::activities() const {
+    std::vector<std::string> result;
+    std::lock_guard<std::mutex> lock(m_framesMutex);
+    for (const Frame& frame : m_frames) {
+        if (frame.opcode == 1 && frame.body.find("\"SET_ACTIVITY\"") != std::string::npos) {
+            result.push_back(frame.body);
+        }
+    }
+    return result;
+}
+
+void FakeDiscord::dropClient() {
+    int client = m_client.load();
+    if (client >= 0) {
+        shutdown(client, SHUT_RDWR);
+    }
+}
+
+FlStudioStub::FlStudioStub() : m_pid(-1) {
+}
+
+FlStudioStub::~FlStudioStub() {
+    stop();
+}
+
+void FlStudioStub::start() {
+    if (m_pid > 0) {
+        return;
+    }
+    m_pid = fork();
+    if (m_pid == 0) {
+        // Don't outlive a test that crashes
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        execl(FLRP_TEST_FL_STUB, "FL64.exe", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    // Until exec the child still carries the test's name
+    std::string commPath = "/proc/" + std::to_string(m_pid) + "/comm";
+    auto start = std::chrono::steady_clock::now();
+    while (msSince(start) < SETTLE_TIMEOUT_MS) {
+        char name[32] = {};
+        FILE* comm = std::fopen(commPath.c_str(), "r");
+        if (comm) {
+            size_t n = std::fread(name, 1, sizeof(name) - 1, comm);
+            std::fclose(comm);
+            if (n > 0 && std::strncmp(name, "FL64.exe", 8) == 0) {
+                return;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::fprintf(stderr, "FL Studio stand-in didn't start\n");
+    std::abort();
+}
+
+void FlStudioStub::stop() {
+    if (m_pid <= 0) {
+        return;
+    }
+    kill(m_pid, SIGKILL);
+    waitpid(m_pid, nullptr, 0);
+    m_pid = -1;
+}
+
+} // namespace test
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * @brief Minimal checks for the test executables
+ *
+ * CHECK records a failure and carries on, so one run reports every broken
+ * expectation. main() returns test::result(), which is non-zero if any
+ * check failed.
+ */
+#define CHECK(cond) ::test::check((cond), #cond, __FILE__, __LINE__)
+
+namespace test {
+
+bool check(bool ok, const char* expression, const char* file, int line);
+
+/**
+ * @brief Process exit code: 0 if every check passed
+ */
+int result();
+
+/**
+ * @brief Milliseconds of real time since start
+ */
+double msSince(std::chrono::steady_clock::time_point start);
+
+/**
+ * @brief Fresh directory under TMPDIR, removed with everything in it on destruction
+ */
+class TempDir {
+    private:
+        std::string m_path;
+
+    public:
+        TempDir();
+        ~TempDir();
+
+        TempDir(const TempDir&) = delete;
+        TempDir& operator=(const TempDir&) = delete;
+
+        const std::string& path() const { return m_path; }
+        std::string file(const std::string& name) const { return m_path + "/" + name; }
+};
+
+/**
+ * @brief Write the FL Studio script's state file the way the script does (write, then rename)
+ */
+void writeStateFile(const std::string& path, const char* state, int bpm, const char* plugin, long long writeTimeMs);
+
+/**
+ * @brief Discord's IPC endpoint, served from a thread in the test process
+ *
+ * Listens on <dir>/discord-ipc-<index>, so pointing XDG_RUNTIME_DIR at dir
+ * makes FLRP find it. Answers the handshake with READY, pings with pongs and
+ * SET_ACTIVITY with the request's nonce, unless the mode says otherwise.
+ */
+class FakeDiscord {
+    public:
+        enum class Mode {
+            Normal,
+            StallHandshake,     // Never sends READY
+            SlowReady,          // Sends READY after readyDelayMs of real time
+            StallResponses,     // READY, then never answers anything, pings included
+            RejectHandshake,    // Answers the handshake with an ERROR dispatch and stays open
+            CloseOnHandshake    // Hangs up on the handshake without a word
+        };
+
+        struct Frame {
+            uint32_t opcode;
+            std::string body;
+        };
+
+    private:
+        std::string m_path;
+        int m_listener;
+        int m_stopPipe[2];                  // Written to stop the server thread
+        std::atomic<int> m_client;
+        std::atomic<Mode> m_mode;
+        std::atomic<int> m_readyDelayMs;
+        std::atomic<bool> m_busy;           // Between reading a frame's header and answering it
+        std::atomic<size_t> m_connections;
+        mutable std::mutex m_framesMutex;
+        std::vector<Frame> m_frames;
+        std::thread m_thread;
+
+        void run();
+        void serve(int client);
+
+    public:
+        explicit FakeDiscord(const std::string& dir, Mode mode = Mode::Normal, int index = 0);
+        ~FakeDiscord();
+
+        FakeDiscord(const FakeDiscord&) = delete;
+        FakeDiscord& operator=(const FakeDiscord&) = delete;
+
+        const std::string& path() const { return m_path; }
+        void setMode(Mode mode) { m_mode.store(mode); }
+        void setReadyDelayMs(int ms) { m_readyDelayMs.store(ms); }
+
+        /**
+         * @brief Wait until everything the client sent has been read and answered
+         */
+        void settle();
+
+        /**
+         * @brief Wait for at least count frames in total
+         * @return false if timeoutMs of real time passed first
+         */
+        bool waitForFrames(size_t count, int timeoutMs);
+
+        std::vector<Frame> frames() const;
+
+        /**
+         * @brief SET_ACTIVITY frames received, in order
+         */
+        std::vector<std::string> activities() const;
+
+        size_t connections() const { return m_connections.load(); }
+
+        /**
+         * @brief Close the current client connection, as Discord does when it quits
+         */
+        void dropClient();
+};
+
+/**
+ * @brief A process named FL64.exe for the process scan to find
+ */
+class FlStudioStub {
+    private:
+        pid_t m_pid;
+
+    public:
+        FlStudioStub();
+        ~FlStudioStub();
+
+        FlStudioStub(const FlStudioStub&) = delete;
+        FlStudioStub& operator=(const FlStudioStub&) = delete;
+
+        /**
+         * @brief Launch the stand-in and wait until /proc shows its name
+         */
+        void start();
+        void stop();
+
+        bool running() const { return m_pid > 0; }
+        pid_t pid() const { return m_pid; }
+};
+
+} // namespace test
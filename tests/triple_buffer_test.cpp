@@ -0,0 +1,97 @@
+// Sensor-to-update handoff: no torn or out-of-order snapshots under contention
+#include "test_support.h"
+#include "triple_buffer.h"
+
+namespace {
+
+// The producer keeps publishing until the consumer has taken this many
+const uint64_t TAKES = 100000;
+const size_t WORDS = 31;
+
+// Every word derives from the sequence, so a torn read shows as a mismatch
+struct Payload {
+    uint64_t sequence;
+    uint64_t words[WORDS];
+};
+
+bool consistent(const Payload& payload) {
+    for (size_t i = 0; i < WORDS; i++) {
+        if (payload.words[i] != payload.sequence * (i + 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    TripleBuffer<Payload> buffer;
+    CHECK(!buffer.update());
+    CHECK(buffer.front().sequence == 0);
+
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> published(0);
+    std::thread producer([&] {
+        uint64_t sequence = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            sequence++;
+            Payload& back = buffer.back();
+            back.sequence = sequence;
+            for (size_t i = 0; i < WORDS; i++) {
+                back.words[i] = sequence * (i + 1);
+            }
+            buffer.publish();
+            // Lets the consumer in on a single core; on more it just runs alongside
+            if (sequence % 4 == 0) {
+                std::this_thread::yield();
+            }
+        }
+        published.store(sequence);
+    });
+
+    uint64_t last = 0;
+    uint64_t taken = 0;
+    uint64_t torn = 0;
+    uint64_t reordered = 0;
+    auto take = [&] {
+        const Payload& front = buffer.front();
+        taken++;
+        // front() must stay put while the producer carries on
+        if (taken % 2 == 0) {
+            std::this_thread::yield();
+        }
+        if (!consistent(front)) {
+            torn++;
+        }
+        if (front.sequence <= last) {
+            reordered++;
+        }
+        last = front.sequence;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    while (taken < TAKES && test::msSince(start) < 30000) {
+        if (buffer.update()) {
+            take();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    stop.store(true);
+    producer.join();
+    // The last value published is always delivered
+    if (buffer.update()) {
+        take();
+    }
+
+    CHECK(taken >= TAKES);
+    CHECK(torn == 0);
+    CHECK(reordered == 0);
+    CHECK(last == published.load());
+    CHECK(!buffer.update());
+    std::printf("%llu publishes, %llu taken by the consumer in %.0f ms\n",
+                static_cast<unsigned long long>(published.load()), static_cast<unsigned long long>(taken),
+                test::msSince(start));
+    return test::result();
+}